@@ -0,0 +1,322 @@
+#pragma once
+#ifndef LINEAGE_FRAME_GRAPH_HXX
+#define LINEAGE_FRAME_GRAPH_HXX
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <andres/graph/adjacency.hxx>
+#include <andres/graph/detail/graph.hxx>
+
+namespace lineage {
+
+/// Immutable undirected graph whose vertices belong to frames.
+///
+/// Adjacencies are stored in compressed sparse rows. Those of a vertex are
+/// sorted by the frame of the neighbour, then by vertex and edge, such that
+/// the adjacencies to the previous frame, within the frame and to the next
+/// frame are consecutive blocks. The vertices of each frame are listed in
+/// one contiguous range. Vertex and edge indices are those passed to the
+/// constructor.
+///
+/// The read-only interface and the iterator types are those of
+/// andres::graph::Graph, such that the andres algorithms apply. For nodes
+/// sorted by frame, the order of adjacencies is that of
+/// andres::graph::Graph as well.
+class FrameGraph
+{
+public:
+    typedef andres::graph::detail::VertexIterator VertexIterator;
+    typedef andres::graph::detail::EdgeIterator EdgeIterator;
+    typedef andres::graph::Adjacency<> AdjacencyType;
+    typedef std::vector<AdjacencyType>::const_iterator AdjacencyIterator;
+
+    FrameGraph() = default;
+
+    /// frames by vertex, and the pairs of vertices by edge.
+    FrameGraph(std::vector<size_t> frames,
+               std::vector<std::pair<size_t, size_t>> const& edges)
+      : frames_(std::move(frames))
+    {
+        const auto numberOfVertices = frames_.size();
+
+        // vertices by frame (counting sort, stable).
+        for (const auto t : frames_) {
+            if (t + 2 > frameBegin_.size())
+                frameBegin_.resize(t + 2, 0);
+            ++frameBegin_[t + 1];
+        }
+        for (size_t t = 1; t < frameBegin_.size(); ++t)
+            frameBegin_[t] += frameBegin_[t - 1];
+
+        verticesInFrame_.resize(numberOfVertices);
+        {
+            auto position = frameBegin_;
+            for (size_t v = 0; v < numberOfVertices; ++v)
+                verticesInFrame_[position[frames_[v]]++] = v;
+        }
+
+        // edges and adjacencies.
+        edges_.reserve(edges.size());
+        rowBegin_.assign(numberOfVertices + 1, 0);
+        for (auto const& e : edges) {
+            if (e.first >= numberOfVertices || e.second >= numberOfVertices)
+                throw std::runtime_error("edge of frame graph out of range.");
+
+            edges_.emplace_back(std::min(e.first, e.second),
+                                std::max(e.first, e.second));
+            ++rowBegin_[e.first + 1];
+            if (e.first != e.second)
+                ++rowBegin_[e.second + 1];
+        }
+        for (size_t v = 0; v < numberOfVertices; ++v)
+            rowBegin_[v + 1] += rowBegin_[v];
+
+        adjacencies_.resize(rowBegin_.back());
+        {
+            std::vector<size_t> position(rowBegin_.begin(),
+                                         rowBegin_.end() - 1);
+            for (size_t e = 0; e < edges_.size(); ++e) {
+                const auto v0 = edges_[e].first;
+                const auto v1 = edges_[e].second;
+                adjacencies_[position[v0]++] = AdjacencyType(v1, e);
+                if (v0 != v1)
+                    adjacencies_[position[v1]++] = AdjacencyType(v0, e);
+            }
+        }
+
+        inFrameBegin_.resize(numberOfVertices);
+        nextFrameBegin_.resize(numberOfVertices);
+        for (size_t v = 0; v < numberOfVertices; ++v) {
+            const auto begin = adjacencies_.begin() + rowBegin_[v];
+            const auto end = adjacencies_.begin() + rowBegin_[v + 1];
+            std::sort(begin, end, AdjacencyOrder{ frames_ });
+
+            const auto t = frames_[v];
+            inFrameBegin_[v] =
+                std::partition_point(begin, end,
+                                     [&](AdjacencyType const& a) {
+                                         return frames_[a.vertex()] < t;
+                                     }) -
+                adjacencies_.begin();
+            nextFrameBegin_[v] =
+                std::partition_point(begin, end,
+                                     [&](AdjacencyType const& a) {
+                                         return frames_[a.vertex()] <= t;
+                                     }) -
+                adjacencies_.begin();
+        }
+    }
+
+    // access (compatible with andres::graph::Graph)
+    size_t numberOfVertices() const { return frames_.size(); }
+    size_t numberOfEdges() const { return edges_.size(); }
+
+    size_t numberOfEdgesFromVertex(const size_t v) const
+    {
+        return rowBegin_[v + 1] - rowBegin_[v];
+    }
+
+    size_t numberOfEdgesToVertex(const size_t v) const
+    {
+        return numberOfEdgesFromVertex(v);
+    }
+
+    size_t vertexOfEdge(const size_t e, const size_t j) const
+    {
+        assert(j < 2);
+        return j == 0 ? edges_[e].first : edges_[e].second;
+    }
+
+    size_t edgeFromVertex(const size_t v, const size_t j) const
+    {
+        return adjacencies_[rowBegin_[v] + j].edge();
+    }
+
+    size_t edgeToVertex(const size_t v, const size_t j) const
+    {
+        return edgeFromVertex(v, j);
+    }
+
+    size_t vertexFromVertex(const size_t v, const size_t j) const
+    {
+        return adjacencies_[rowBegin_[v] + j].vertex();
+    }
+
+    size_t vertexToVertex(const size_t v, const size_t j) const
+    {
+        return vertexFromVertex(v, j);
+    }
+
+    AdjacencyType const& adjacencyFromVertex(const size_t v,
+                                             const size_t j) const
+    {
+        return adjacencies_[rowBegin_[v] + j];
+    }
+
+    AdjacencyType const& adjacencyToVertex(const size_t v,
+                                           const size_t j) const
+    {
+        return adjacencyFromVertex(v, j);
+    }
+
+    /// pair.second is 0 if no edge exists.
+    std::pair<bool, size_t> findEdge(size_t v0, size_t v1) const
+    {
+        if (numberOfEdgesFromVertex(v1) < numberOfEdgesFromVertex(v0))
+            std::swap(v0, v1);
+
+        const auto end = adjacenciesFromVertexEnd(v0);
+        const auto it = std::lower_bound(adjacenciesFromVertexBegin(v0), end,
+                                         AdjacencyType(v1, 0),
+                                         AdjacencyOrder{ frames_ });
+
+        if (it != end && it->vertex() == v1)
+            return std::make_pair(true, it->edge());
+        else
+            return std::make_pair(false, 0);
+    }
+
+    bool multipleEdgesEnabled() const { return false; }
+
+    // iterator access (compatible with andres::graph::Graph)
+    AdjacencyIterator adjacenciesFromVertexBegin(const size_t v) const
+    {
+        return adjacencies_.begin() + rowBegin_[v];
+    }
+
+    AdjacencyIterator adjacenciesFromVertexEnd(const size_t v) const
+    {
+        return adjacencies_.begin() + rowBegin_[v + 1];
+    }
+
+    AdjacencyIterator adjacenciesToVertexBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    AdjacencyIterator adjacenciesToVertexEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    VertexIterator verticesFromVertexBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    VertexIterator verticesFromVertexEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    VertexIterator verticesToVertexBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    VertexIterator verticesToVertexEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    EdgeIterator edgesFromVertexBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    EdgeIterator edgesFromVertexEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    EdgeIterator edgesToVertexBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    EdgeIterator edgesToVertexEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    // blocks of adjacencies by frame of the neighbour.
+    AdjacencyIterator adjacenciesToPreviousFrameBegin(const size_t v) const
+    {
+        return adjacenciesFromVertexBegin(v);
+    }
+
+    AdjacencyIterator adjacenciesToPreviousFrameEnd(const size_t v) const
+    {
+        return adjacencies_.begin() + inFrameBegin_[v];
+    }
+
+    AdjacencyIterator adjacenciesInFrameBegin(const size_t v) const
+    {
+        return adjacencies_.begin() + inFrameBegin_[v];
+    }
+
+    AdjacencyIterator adjacenciesInFrameEnd(const size_t v) const
+    {
+        return adjacencies_.begin() + nextFrameBegin_[v];
+    }
+
+    AdjacencyIterator adjacenciesToNextFrameBegin(const size_t v) const
+    {
+        return adjacencies_.begin() + nextFrameBegin_[v];
+    }
+
+    AdjacencyIterator adjacenciesToNextFrameEnd(const size_t v) const
+    {
+        return adjacenciesFromVertexEnd(v);
+    }
+
+    // frames.
+    size_t numberOfFrames() const
+    {
+        return frameBegin_.empty() ? 0 : frameBegin_.size() - 1;
+    }
+
+    size_t frameOfVertex(const size_t v) const { return frames_[v]; }
+
+    size_t numberOfVerticesInFrame(const size_t t) const
+    {
+        return frameBegin_[t + 1] - frameBegin_[t];
+    }
+
+    size_t vertexInFrame(const size_t t, const size_t j) const
+    {
+        return verticesInFrame_[frameBegin_[t] + j];
+    }
+
+private:
+    // by frame of the neighbour, then by vertex and edge.
+    struct AdjacencyOrder
+    {
+        std::vector<size_t> const& frames;
+
+        bool operator()(AdjacencyType const& a, AdjacencyType const& b) const
+        {
+            if (frames[a.vertex()] != frames[b.vertex()])
+                return frames[a.vertex()] < frames[b.vertex()];
+            return a < b;
+        }
+    };
+
+    std::vector<size_t> frames_; // by vertex
+    std::vector<size_t> frameBegin_;
+    std::vector<size_t> verticesInFrame_;
+
+    std::vector<std::pair<size_t, size_t>> edges_;
+    std::vector<size_t> rowBegin_;
+    std::vector<AdjacencyType> adjacencies_;
+    std::vector<size_t> inFrameBegin_;   // by vertex
+    std::vector<size_t> nextFrameBegin_; // by vertex
+};
+
+} // namespace lineage
+
+#endif
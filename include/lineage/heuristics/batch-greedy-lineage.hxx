@@ -0,0 +1,192 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_BATCH_GREEDY_LINEAGE_HXX
+#define LINEAGE_HEURISTICS_BATCH_GREEDY_LINEAGE_HXX
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "greedy-lineage.hxx"
+
+namespace lineage {
+namespace heuristics {
+
+/// Greedy lineage agglomeration that applies a batch of moves per iteration.
+///
+/// A batch is taken from the top of the queue and contains only moves whose
+/// closed neighbourhoods (endpoints and their neighbours, which include
+/// their parents and children) are pairwise disjoint. The delta of such a
+/// move does not depend on any other move of the batch, so all of them are
+/// applied with their queued delta. Afterwards, the moves depending on the
+/// batch are evaluated concurrently.
+template <class EVA = std::vector<double>>
+class BatchGreedyLineageAgglomeration : public GreedyLineageAgglomeration<EVA>
+{
+public:
+    using Base = GreedyLineageAgglomeration<EVA>;
+    using EdgeOperation = typename Base::EdgeOperation;
+
+    BatchGreedyLineageAgglomeration(Data& data)
+      : Base(data)
+      , locks_(this->vertices_.numberOfVertices(), 0)
+      , maxBatchSize_(std::max<size_t>(1, data.maxBatchSize))
+      , numberOfThreads_(data.threadPool->numberOfThreads())
+    {
+    }
+
+    inline bool virtual applyBestOperationAndUpdate()
+    {
+        selectBatch();
+        if (batch_.empty())
+            return false;
+
+        applied_.clear();
+        for (auto const& move : batch_)
+            applied_.push_back(this->applyQueuedMove(move));
+
+        edges_.clear();
+        for (auto const& applied : applied_)
+            this->forEachDependentEdge(applied, [this](size_t v0, size_t v1) {
+                edges_.push_back(std::minmax(v0, v1));
+            });
+
+        std::sort(edges_.begin(), edges_.end());
+        edges_.erase(std::unique(edges_.begin(), edges_.end()), edges_.end());
+
+        proposeEdges();
+        return true;
+    }
+
+    inline void virtual optimize()
+    {
+        // initial queue of operations.
+        edges_.clear();
+        for (size_t v0 = 0; v0 < this->vertices_.numberOfVertices(); ++v0)
+            for (const auto& other : this->getAdjacentVertices(v0))
+                if (v0 < other.vertex)
+                    edges_.emplace_back(v0, other.vertex);
+
+        proposeEdges();
+
+        size_t iter = 0;
+        size_t moves = 0;
+        while (applyBestOperationAndUpdate()) {
+            if (not this->silent_)
+                this->logObj(this->numberOfProposals_);
+            ++iter;
+            moves += batch_.size();
+        }
+
+        if (not this->silent_) {
+            this->data_.timer.stop();
+            std::cout << "[BGLA] Stopping after " << moves << " moves in "
+                      << iter << " batches in "
+                      << this->data_.timer.get_elapsed_seconds()
+                      << "s. Obj=" << this->objective_ << std::endl;
+            this->data_.timer.start();
+        }
+    }
+
+protected:
+    /// take improving moves from the top of the queue until the batch is
+    /// full. Moves that conflict with the batch return to the queue.
+    inline void selectBatch()
+    {
+        batch_.clear();
+        rejected_.clear();
+        ++lockEpoch_;
+
+        // bound the search for independent moves.
+        const size_t maxCandidates = 2 * maxBatchSize_;
+
+        while (!this->queue_.empty() && batch_.size() < maxBatchSize_ &&
+               batch_.size() + rejected_.size() < maxCandidates) {
+            const auto move = this->queue_.top();
+            if (move.delta >= 0)
+                break;
+
+            this->withdrawMove(move.v0, move.v1);
+
+            if (isIndependent(move)) {
+                lock(move);
+                batch_.push_back(move);
+            } else {
+                rejected_.push_back(move);
+            }
+        }
+
+        for (auto const& move : rejected_)
+            this->enqueue(move.v0, move.v1, move);
+    }
+
+    inline bool isIndependent(const EdgeOperation& move) const
+    {
+        for (auto v : { move.v0, move.v1 }) {
+            if (locks_[v] == lockEpoch_)
+                return false;
+
+            for (auto const& w : this->getAdjacentVertices(v))
+                if (locks_[w.vertex] == lockEpoch_)
+                    return false;
+        }
+        return true;
+    }
+
+    inline void lock(const EdgeOperation& move)
+    {
+        for (auto v : { move.v0, move.v1 }) {
+            locks_[v] = lockEpoch_;
+            for (auto const& w : this->getAdjacentVertices(v))
+                locks_[w.vertex] = lockEpoch_;
+        }
+    }
+
+    /// evaluate the moves along edges_ on the thread pool and queue them.
+    inline void proposeEdges()
+    {
+        proposals_.assign(edges_.size(), EdgeOperation(0, 0, .0));
+
+        auto evaluate = [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                proposals_[i] = DynamicLineage<EVA>::proposeMove(
+                    edges_[i].first, edges_[i].second);
+        };
+
+        // small batches are not worth the thread overhead.
+        const size_t minChunkSize = 1024;
+        const auto numberOfChunks = std::min(
+            numberOfThreads_, 1 + edges_.size() / minChunkSize);
+
+        const auto chunkSize =
+            (edges_.size() + numberOfChunks - 1) / numberOfChunks;
+
+        this->data_.threadPool->parallelFor(numberOfChunks, [&](size_t i) {
+            evaluate(std::min(i * chunkSize, edges_.size()),
+                     std::min((i + 1) * chunkSize, edges_.size()));
+        });
+
+        for (size_t i = 0; i < edges_.size(); ++i)
+            this->enqueue(edges_[i].first, edges_[i].second, proposals_[i]);
+
+        this->numberOfProposals_ = edges_.size();
+    }
+
+    std::vector<EdgeOperation> batch_;
+    std::vector<EdgeOperation> rejected_;
+    std::vector<typename Base::AppliedMove> applied_;
+    std::vector<std::pair<size_t, size_t>> edges_;
+    std::vector<EdgeOperation> proposals_;
+
+    // vertices in the closed neighbourhood of the batch.
+    size_t lockEpoch_{ 0 };
+    std::vector<size_t> locks_;
+
+    size_t maxBatchSize_; // moves applied per iteration, see Data
+    size_t numberOfThreads_;
+};
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -0,0 +1,191 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_DYNAMIC_ADJACENCY_HXX
+#define LINEAGE_HEURISTICS_DYNAMIC_ADJACENCY_HXX
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace lineage {
+namespace heuristics {
+
+/// Weighted adjacency of a graph under edge contraction.
+///
+/// The neighbourhood of each vertex is a vector sorted by neighbour index,
+/// such that lookups are binary searches on contiguous memory and
+/// contracting an edge merges two sorted ranges. Each edge additionally
+/// carries a handle (e.g. into a priority queue) that is stored with its
+/// smaller endpoint. Edges created by a contraction start with noHandle().
+template <class T>
+class DynamicAdjacency
+{
+public:
+    struct Neighbour
+    {
+        size_t vertex;
+        T weight;
+        size_t handle;
+    };
+
+    using Neighbourhood = std::vector<Neighbour>;
+
+    static constexpr size_t noHandle()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    explicit DynamicAdjacency(size_t numberOfVertices = 0)
+      : vertices_(numberOfVertices)
+    {
+    }
+
+    size_t numberOfVertices() const { return vertices_.size(); }
+
+    Neighbourhood const& neighbours(size_t v) const { return vertices_[v]; }
+
+    void reserve(size_t v, size_t numberOfNeighbours)
+    {
+        vertices_[v].reserve(numberOfNeighbours);
+    }
+
+    bool edgeExists(size_t a, size_t b) const
+    {
+        return find(vertices_[a], b) != vertices_[a].end();
+    }
+
+    T weight(size_t a, size_t b) const
+    {
+        const auto it = find(vertices_[a], b);
+        if (it == vertices_[a].end())
+            throw std::out_of_range("edge does not exist.");
+        return it->weight;
+    }
+
+    size_t& handle(size_t a, size_t b)
+    {
+        if (a > b)
+            std::swap(a, b);
+
+        const auto it = find(vertices_[a], b);
+        if (it == vertices_[a].end())
+            throw std::out_of_range("edge does not exist.");
+        return vertices_[a][it - vertices_[a].begin()].handle;
+    }
+
+    /// add w to the weight of edge {a, b}, inserting the edge if necessary.
+    void addWeight(size_t a, size_t b, T w)
+    {
+        addWeightDirected(vertices_[a], b, w);
+        addWeightDirected(vertices_[b], a, w);
+    }
+
+    void removeVertex(size_t v)
+    {
+        for (auto const& n : vertices_[v]) {
+            auto& other = vertices_[n.vertex];
+            other.erase(lowerBound(other, v));
+        }
+        vertices_[v].clear();
+    }
+
+    /// contract edge {stable, merge}: the neighbourhood of merge is added
+    /// to the neighbourhood of stable and merge becomes isolated.
+    void contract(size_t stable, size_t merge)
+    {
+        auto& stableNeighbours = vertices_[stable];
+        auto& mergeNeighbours = vertices_[merge];
+
+        // redirect neighbours of merge to stable.
+        for (auto const& n : mergeNeighbours)
+            if (n.vertex != stable)
+                redirect(vertices_[n.vertex], merge, stable);
+
+        // merge both sorted neighbourhoods.
+        buffer_.clear();
+        auto s = stableNeighbours.cbegin();
+        auto m = mergeNeighbours.cbegin();
+        while (s != stableNeighbours.cend() || m != mergeNeighbours.cend()) {
+            if (s != stableNeighbours.cend() && s->vertex == merge) {
+                ++s;
+            } else if (m != mergeNeighbours.cend() && m->vertex == stable) {
+                ++m;
+            } else if (m == mergeNeighbours.cend() ||
+                       (s != stableNeighbours.cend() &&
+                        s->vertex < m->vertex)) {
+                buffer_.push_back(*s++);
+            } else if (s == stableNeighbours.cend() ||
+                       m->vertex < s->vertex) {
+                buffer_.push_back({ m->vertex, m->weight, noHandle() });
+                ++m;
+            } else {
+                buffer_.push_back(*s++);
+                buffer_.back().weight += (m++)->weight;
+            }
+        }
+
+        // the previous neighbourhood of stable becomes the next buffer.
+        stableNeighbours.swap(buffer_);
+        mergeNeighbours.clear();
+    }
+
+private:
+    using iterator = typename Neighbourhood::iterator;
+    using const_iterator = typename Neighbourhood::const_iterator;
+
+    static iterator lowerBound(Neighbourhood& neighbours, size_t v)
+    {
+        return std::lower_bound(
+            neighbours.begin(), neighbours.end(), v,
+            [](Neighbour const& n, size_t w) { return n.vertex < w; });
+    }
+
+    static const_iterator find(Neighbourhood const& neighbours, size_t v)
+    {
+        const auto it = std::lower_bound(
+            neighbours.cbegin(), neighbours.cend(), v,
+            [](Neighbour const& n, size_t w) { return n.vertex < w; });
+        if (it != neighbours.cend() && it->vertex == v)
+            return it;
+        return neighbours.cend();
+    }
+
+    static void addWeightDirected(Neighbourhood& neighbours, size_t v, T w)
+    {
+        const auto it = lowerBound(neighbours, v);
+        if (it != neighbours.end() && it->vertex == v)
+            it->weight += w;
+        else
+            neighbours.insert(it, { v, w, noHandle() });
+    }
+
+    // replace the entry of from by to, adding its weight to an existing
+    // entry of to.
+    static void redirect(Neighbourhood& neighbours, size_t from, size_t to)
+    {
+        const auto source = lowerBound(neighbours, from);
+        const auto target = lowerBound(neighbours, to);
+
+        if (target != neighbours.end() && target->vertex == to) {
+            target->weight += source->weight;
+            neighbours.erase(source);
+        } else {
+            source->vertex = to;
+            source->handle = noHandle();
+
+            // restore order.
+            if (target <= source)
+                std::rotate(target, source, source + 1);
+            else
+                std::rotate(source, source + 1, target);
+        }
+    }
+
+    std::vector<Neighbourhood> vertices_;
+    Neighbourhood buffer_;
+};
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -9,7 +9,6 @@
 #include <limits>
 #include <map>
 #include <numeric>
-#include <queue>
 #include <random>
 #include <sstream>
 #include <stack>
@@ -20,7 +19,9 @@
 
 #include <levinkov/timer.hxx>
 
+#include "dynamic-adjacency.hxx"
 #include "heuristic-base.hxx"
+#include "indexed-heap.hxx"
 #include "lineage/evaluate.hxx"
 #include "lineage/problem-graph.hxx"
 #include "lineage/solution.hxx"
@@ -34,37 +35,43 @@ class DynamicLineage
     /// Class adapted from
     /// andres::graph::multicut::greedyAdditiveEdgeContraction
 public:
+    using Adjacency = DynamicAdjacency<typename EVA::value_type>;
+
     DynamicLineage(Data& data)
       : data_(data)
       , vertices_(data.problemGraph.graph().numberOfVertices())
-      , partition_(vertices_.size())
-      , parents_(vertices_.size())
-      , children_(vertices_.size(), 0)
-      , sizes_(vertices_.size(), 1)
+      , partition_(vertices_.numberOfVertices())
+      , parents_(vertices_.numberOfVertices())
+      , children_(vertices_.numberOfVertices(), 0)
+      , sizes_(vertices_.numberOfVertices(), 1)
     {
         setup();
     }
 
     struct EdgeOperation
     {
-        EdgeOperation(size_t _v0, size_t _v1, typename EVA::value_type _delta,
-                      size_t _edition = 0)
+        EdgeOperation(size_t _v0, size_t _v1, typename EVA::value_type _delta)
         {
             v0 = _v0;
             v1 = _v1;
             delta = _delta;
-            edition = _edition;
         }
         size_t v0, v1;
-        size_t edition;
 
         typename EVA::value_type delta;
+        size_t proposal{ 0 }; // sequence number, set when queued.
 
         inline bool operator<(const EdgeOperation& other) const
         {
-            return delta >
-                   other.delta; // inversed operation due to default-max order
-                                // in queue.
+            // inversed operation due to default-max order in queue. Ties
+            // are broken by the most recent proposal, which is the order
+            // in which a std::priority_queue of pushed moves tends to
+            // return them and was found to agglomerate better than a fixed
+            // order of the edges.
+            if (delta != other.delta)
+                return delta > other.delta;
+
+            return proposal < other.proposal;
         }
     };
 
@@ -74,6 +81,9 @@ public:
         const auto& costs = data_.costs;
         std::iota(parents_.begin(), parents_.end(), 0);
 
+        for (size_t v = 0; v < graph.numberOfVertices(); ++v)
+            vertices_.reserve(v, graph.numberOfEdgesFromVertex(v));
+
         for (size_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
 
             const auto& v0 = graph.vertexOfEdge(edge, 0);
@@ -94,7 +104,7 @@ public:
             const auto v1 = data_.problemGraph.graph().vertexOfEdge(edge, 1);
 
             if (edge_labels[edge] == 0) {
-                applyMove({ v0, v1, 0, 0 });
+                applyMove({ v0, v1, 0 });
             }
         }
     }
@@ -113,33 +123,25 @@ public:
 
     inline bool edgeExists(size_t a, size_t b) const
     {
-        return !vertices_[a].empty() &&
-               vertices_[a].find(b) != vertices_[a].end();
+        return vertices_.edgeExists(a, b);
     }
 
-    inline std::map<size_t, typename EVA::value_type> const&
-    getAdjacentVertices(size_t v) const
+    inline typename Adjacency::Neighbourhood const& getAdjacentVertices(
+        size_t v) const
     {
-        return vertices_[v];
+        return vertices_.neighbours(v);
     }
 
     inline typename EVA::value_type getEdgeWeight(size_t a, size_t b) const
     {
-        return vertices_[a].at(b);
+        return vertices_.weight(a, b);
     }
 
-    inline void removeVertex(size_t v)
-    {
-        for (auto& p : vertices_[v])
-            vertices_[p.first].erase(v);
-
-        vertices_[v].clear();
-    }
+    inline void removeVertex(size_t v) { vertices_.removeVertex(v); }
 
     inline void updateEdgeWeight(size_t a, size_t b, typename EVA::value_type w)
     {
-        vertices_[a][b] += w;
-        vertices_[b][a] += w;
+        vertices_.addWeight(a, b, w);
     }
 
     inline void setParent(size_t child, size_t parent)
@@ -172,6 +174,14 @@ public:
         }
     }
 
+    /// read-only lookup that does not update the lookup table.
+    inline size_t findParent(size_t v) const
+    {
+        auto rep = findRep(v);
+        auto parent = findRep(parents_[rep]);
+        return parent == rep ? v : parent;
+    }
+
     inline std::pair<bool, size_t> hasParent(size_t v)
     {
         auto parent = findParent(v);
@@ -179,13 +189,19 @@ public:
         return std::make_pair(found, parent);
     }
 
-    inline size_t children(size_t v)
+    inline std::pair<bool, size_t> hasParent(size_t v) const
+    {
+        auto parent = findParent(v);
+        return std::make_pair(parent != v, parent);
+    }
+
+    inline size_t children(size_t v) const
     {
         auto rep = findRep(v);
         return children_[rep];
     }
 
-    inline bool hasChild(size_t v) { return children(v) > 0; }
+    inline bool hasChild(size_t v) const { return children(v) > 0; }
 
     inline void addChild(size_t v)
     {
@@ -207,6 +223,9 @@ public:
 
     inline size_t findRep(size_t v) { return partition_.find(v); }
 
+    /// read-only lookup without path compression.
+    inline size_t findRep(size_t v) const { return partition_.find(v); }
+
     inline void merge(const size_t v0, const size_t v1)
     {
 
@@ -269,17 +288,7 @@ public:
 #endif
 
         // update all edges.
-        for (const auto& p : getAdjacentVertices(merge_vertex)) {
-
-            const auto& other_vertex = p.first;
-            if (other_vertex == stable_vertex) {
-                continue;
-            }
-
-            updateEdgeWeight(stable_vertex, other_vertex, p.second);
-        }
-
-        removeVertex(merge_vertex);
+        vertices_.contract(stable_vertex, merge_vertex);
 
         // apply previous settings.
         {
@@ -294,12 +303,12 @@ public:
         }
     }
 
-    size_t sizeOf(size_t v0) { return sizes_[findRep(v0)]; }
+    size_t sizeOf(size_t v0) const { return sizes_[findRep(v0)]; }
 
-    inline EdgeOperation proposeMove(const size_t v0, const size_t v1)
+    /// evaluate the move along (v0, v1). The state is only read, such that
+    /// moves can be evaluated concurrently.
+    inline EdgeOperation proposeMove(const size_t v0, const size_t v1) const
     {
-        // increaseEdition(v0, v1); // invalidate old moves along (v0, v1)
-
         if (!edgeExists(v0, v1)) {
             throw std::runtime_error(
                 "Cannot propose move for an edge that does not exist!");
@@ -329,14 +338,14 @@ public:
             } else { // the rest cant.
                 return {
                     v0, v1,
-                    std::numeric_limits<typename EVA::value_type>::infinity(), 0
+                    std::numeric_limits<typename EVA::value_type>::infinity()
                 };
             }
 
             // cost adjustments for all nodes that have either first
             // or second as a parent and share connections to the other.
             for (const auto& other : getAdjacentVertices(v1)) {
-                const auto& v2 = other.first;
+                const auto& v2 = other.vertex;
                 const auto& p2 = hasParent(v2);
 
                 if (edgeExists(v0, v2)) {
@@ -378,7 +387,7 @@ public:
                     std::numeric_limits<typename EVA::value_type>::infinity();
             }
 
-            return { v0, v1, delta, 0 };
+            return { v0, v1, delta };
 
             // Potential new parent.
         } else {
@@ -394,8 +403,7 @@ public:
             if (this->data_.enforceBifurcationConstraint) {
                 if (children(parent) >= 2) {
                     return { v0, v1, std::numeric_limits<
-                                         typename EVA::value_type>::infinity(),
-                             0 };
+                                         typename EVA::value_type>::infinity() };
                 }
             }
 
@@ -407,8 +415,7 @@ public:
                     if (parentOfChild.second == parent) {
                         return { child, parent,
                                  std::numeric_limits<
-                                     typename EVA::value_type>::infinity(),
-                                 0 };
+                                     typename EVA::value_type>::infinity() };
                     } else {
                         if (!edgeExists(child, parentOfChild.second)) {
                             throw std::runtime_error(
@@ -435,7 +442,7 @@ public:
                 delta -= data_.costTermination * sizeOf(parent);
             }
 
-            return { v0, v1, delta, 0 };
+            return { v0, v1, delta };
         }
     }
 
@@ -458,12 +465,12 @@ public:
         this->objective_ += move.delta;
     }
 
-    inline size_t getFrameOfNode(const size_t vertex)
+    inline size_t getFrameOfNode(const size_t vertex) const
     {
         return data_.problemGraph.frameOfNode(vertex);
     }
 
-    inline void logObj()
+    inline void logObj(const size_t numberOfProposals = 0)
     {
         data_.timer.stop();
 
@@ -474,14 +481,9 @@ public:
                << "nan"    // gap
                << " 0 0 0" // violated constraints;
                << " 0 0 0" // termination/birth/bifuraction constr.
-               << " 0 0\n";
+               << " 0 0 " << numberOfProposals << "\n";
 
-        {
-            std::ofstream file(data_.solutionName + "-optimization-log.txt",
-                               std::ofstream::out | std::ofstream::app);
-            file << stream.str();
-            file.close();
-        }
+        data_.log.append(stream.str());
 
         data_.timer.start();
     }
@@ -526,7 +528,7 @@ protected:
     using Partition = andres::Partition<size_t>;
     Data& data_;
 
-    std::vector<std::map<size_t, typename EVA::value_type>> vertices_;
+    Adjacency vertices_;
     Partition partition_;
     std::vector<size_t> parents_;
     std::vector<size_t> children_;
@@ -539,87 +541,214 @@ template <class EVA = std::vector<double>>
 class GreedyLineageAgglomeration : public DynamicLineage<EVA>
 {
 public:
+    using Adjacency = typename DynamicLineage<EVA>::Adjacency;
+    using EdgeOperation = typename DynamicLineage<EVA>::EdgeOperation;
+
     GreedyLineageAgglomeration(Data& data)
       : DynamicLineage<EVA>(data)
-      , editions_(data.problemGraph.graph().numberOfVertices())
+      , incrementalReproposal_(data.incrementalReproposal)
+      , stamps_(this->vertices_.numberOfVertices(), 0)
+      , neighbourStamps_(this->vertices_.numberOfVertices(), 0)
     {
     }
 
     // dummy function to be compatible with standard interface.
     void setMaxIter(const size_t maxIter) { ; }
 
-    inline void increaseEdition(const size_t v0, const size_t v1)
+    /// (re-)propose the move along (v0, v1).
+    inline void proposeMove(const size_t v0, const size_t v1)
     {
-        if (!this->edgeExists(v0, v1)) {
-            throw std::runtime_error(
-                "Cannot increase edition of an edge that does not exist!");
-        }
-        if (v0 > v1) {
-            ++editions_[v1][v0];
-        } else {
-            ++editions_[v0][v1];
-        }
+        ++numberOfProposals_;
+        enqueue(v0, v1, DynamicLineage<EVA>::proposeMove(v0, v1));
     }
 
-    inline size_t getEdition(const size_t v0, const size_t v1)
+    /// store move as the move along (v0, v1). The queue holds at most one
+    /// move per edge, the latest one, and only while it does not increase
+    /// the objective.
+    inline void enqueue(const size_t v0, const size_t v1,
+                        const EdgeOperation& move)
     {
-        if (v0 > v1) {
-            return editions_[v1][v0];
-        } else {
-            return editions_[v0][v1];
+        auto& handle = this->vertices_.handle(v0, v1);
+        if (move.delta <= .0) {
+            auto queued = move;
+            queued.proposal = ++proposalSequence_;
+            if (handle == Adjacency::noHandle())
+                handle = queue_.push(queued);
+            else
+                queue_.update(handle, queued);
+        } else if (handle != Adjacency::noHandle()) {
+            withdrawMove(v0, v1);
         }
     }
 
-    inline void proposeMove(const size_t v0, const size_t v1)
+    /// remove the move along (v0, v1) from the queue, if any.
+    inline void withdrawMove(const size_t v0, const size_t v1)
     {
-        increaseEdition(v0, v1); // invalidate old moves along (v0, v1)
-        auto move = DynamicLineage<EVA>::proposeMove(v0, v1);
-        if (move.delta <= .0) {
-            move.edition = getEdition(move.v0, move.v1);
-            queue_.push(move);
+        auto& handle = this->vertices_.handle(v0, v1);
+        if (handle != Adjacency::noHandle()) {
+            queue_.erase(handle);
+            handle = Adjacency::noHandle();
         }
     }
 
     inline bool virtual applyBestOperationAndUpdate()
     {
-        while (!queue_.empty()) {
+        if (queue_.empty())
+            return false;
 
-            const auto move = queue_.top();
-            queue_.pop();
+        const auto move = queue_.top();
+        if (move.delta >= 0)
+            return false;
 
-            if (move.delta >= 0) {
-                return false;
-            } else if (!this->edgeExists(move.v0, move.v1)) {
-                continue;
-            } else if (move.edition != getEdition(move.v0, move.v1)) {
-                continue;
-            }
+        const auto applied = applyQueuedMove(move);
 
-            this->applyMove(move);
+        numberOfProposals_ = 0;
+        forEachDependentEdge(
+            applied, [this](size_t v0, size_t v1) { proposeMove(v0, v1); });
 
-            std::vector<size_t> neighbours;
-            for (auto v : { move.v0, move.v1 }) {
-                for (auto w : this->vertices_[v]) {
-                    neighbours.push_back(w.first);
-                }
+        return true;
+    }
+
+protected:
+    struct AppliedMove
+    {
+        EdgeOperation move;
+        bool isMerge;
+
+        // besides the endpoints, a move changes the number of children of
+        // a former parent: the common parent of merged clusters or the
+        // previous parent of a re-set child.
+        std::pair<bool, size_t> formerParent;
+    };
+
+    inline AppliedMove applyQueuedMove(const EdgeOperation& move)
+    {
+        AppliedMove applied{ move, this->getFrameOfNode(move.v0) ==
+                                       this->getFrameOfNode(move.v1),
+                             { false, 0 } };
+
+        // a merge removes all edges of one of its vertices, so their moves
+        // have to leave the queue before. All remaining edges of both
+        // vertices are re-proposed afterwards.
+        if (applied.isMerge) {
+            const auto p0 = this->hasParent(move.v0);
+            const auto p1 = this->hasParent(move.v1);
+            if (p0.first && p1.first)
+                applied.formerParent = p0;
+
+            for (auto v : { move.v0, move.v1 })
+                for (auto const& w : this->getAdjacentVertices(v))
+                    withdrawMove(v, w.vertex);
+        } else {
+            const auto child =
+                this->getFrameOfNode(move.v0) > this->getFrameOfNode(move.v1)
+                    ? move.v0
+                    : move.v1;
+            applied.formerParent = this->hasParent(child);
+
+            withdrawMove(move.v0, move.v1);
+        }
+
+        this->applyMove(move);
+
+        return applied;
+    }
+
+    /// call f(v0, v1) for every edge whose move has to be re-proposed after
+    /// applied, depending on the re-proposal mode.
+    template <class F>
+    inline void forEachDependentEdge(const AppliedMove& applied, F&& f)
+    {
+        if (incrementalReproposal_)
+            forEachDependentEdgeIncremental(applied, f);
+        else
+            forEachNeighbourhoodEdge(applied.move, f);
+    }
+
+    /// all edges of neighbours of the endpoints.
+    template <class F>
+    inline void forEachNeighbourhoodEdge(const EdgeOperation& move, F& f)
+    {
+        std::vector<size_t> neighbours;
+        for (auto v : { move.v0, move.v1 }) {
+            for (auto const& w : this->getAdjacentVertices(v)) {
+                neighbours.push_back(w.vertex);
             }
+        }
 
-            for (auto v : neighbours) {
-                for (auto w : this->vertices_[v]) {
-                    proposeMove(v, w.first);
-                }
+        for (auto v : neighbours) {
+            for (auto const& w : this->getAdjacentVertices(v)) {
+                f(v, w.vertex);
             }
-            return true;
         }
-        return false;
     }
 
+    /// exactly the edges whose delta depends on the clusters changed by the
+    /// move, each once. These are
+    ///   - all edges of a cluster whose parent, number of children, size or
+    ///     adjacency changed, and of the children of such a cluster whose
+    ///     number of children changed (re-setting them is priced with a
+    ///     possible termination of their parent),
+    ///   - after a merge, the intra-frame edges between two neighbours of
+    ///     the merged cluster, since their delta accounts for shared
+    ///     neighbours.
+    template <class F>
+    inline void forEachDependentEdgeIncremental(const AppliedMove& applied,
+                                                F& f)
+    {
+        const auto& move = applied.move;
+
+        ++epoch_;
+        changed_.clear();
+
+        if (applied.isMerge) {
+            const auto cluster = this->findRep(move.v0);
+            markWithChildren(cluster);
+
+            for (auto const& w : this->getAdjacentVertices(cluster))
+                neighbourStamps_[w.vertex] = epoch_;
+        } else {
+            auto child = move.v0;
+            auto parent = move.v1;
+            if (this->getFrameOfNode(child) < this->getFrameOfNode(parent))
+                std::swap(child, parent);
+
+            mark(child);
+            markWithChildren(parent);
+        }
+
+        if (applied.formerParent.first)
+            markWithChildren(applied.formerParent.second);
+
+        for (auto v : changed_)
+            for (auto const& w : this->getAdjacentVertices(v))
+                if (stamps_[w.vertex] != epoch_ || v < w.vertex)
+                    f(v, w.vertex);
+
+        if (!applied.isMerge)
+            return;
+
+        const auto cluster = this->findRep(move.v0);
+        for (auto const& u : this->getAdjacentVertices(cluster)) {
+            if (stamps_[u.vertex] == epoch_)
+                continue;
+
+            const auto frame = this->getFrameOfNode(u.vertex);
+            for (auto const& w : this->getAdjacentVertices(u.vertex))
+                if (u.vertex < w.vertex && stamps_[w.vertex] != epoch_ &&
+                    neighbourStamps_[w.vertex] == epoch_ &&
+                    this->getFrameOfNode(w.vertex) == frame)
+                    f(u.vertex, w.vertex);
+        }
+    }
+
+public:
     inline void virtual optimize()
     {
         // initial queue of operations.
-        for (size_t v0 = 0; v0 < this->vertices_.size(); ++v0) {
-            for (const auto& other : this->vertices_[v0]) {
-                const auto v1 = other.first;
+        for (size_t v0 = 0; v0 < this->vertices_.numberOfVertices(); ++v0) {
+            for (const auto& other : this->getAdjacentVertices(v0)) {
+                const auto v1 = other.vertex;
                 proposeMove(v0, v1);
             }
         }
@@ -627,7 +756,7 @@ public:
         size_t iter = 0;
         while (applyBestOperationAndUpdate()) {
             if (not silent_)
-                this->logObj();
+                this->logObj(numberOfProposals_);
             ++iter;
         }
 
@@ -643,9 +772,36 @@ public:
     inline void setSilent(const bool flag) { silent_ = flag; }
 
 protected:
-    std::priority_queue<typename DynamicLineage<EVA>::EdgeOperation> queue_;
-    std::vector<std::map<size_t, size_t>> editions_;
+    inline void mark(const size_t v)
+    {
+        if (stamps_[v] != epoch_) {
+            stamps_[v] = epoch_;
+            changed_.push_back(v);
+        }
+    }
+
+    inline void markWithChildren(const size_t v)
+    {
+        mark(v);
+        for (auto const& w : this->getAdjacentVertices(v)) {
+            const auto parent = this->hasParent(w.vertex);
+            if (parent.first && parent.second == v)
+                mark(w.vertex);
+        }
+    }
+
+    IndexedHeap<EdgeOperation> queue_;
     bool silent_{ false };
+
+    bool incrementalReproposal_{ false };
+    size_t numberOfProposals_{ 0 }; // since the last move
+    size_t proposalSequence_{ 0 };  // of all queued moves, cf. EdgeOperation
+
+    // clusters whose moves are all re-proposed, marked by the current epoch.
+    size_t epoch_{ 0 };
+    std::vector<size_t> stamps_;
+    std::vector<size_t> neighbourStamps_;
+    std::vector<size_t> changed_;
 };
 
 } // namespace heuristics
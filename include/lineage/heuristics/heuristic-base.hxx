@@ -55,21 +55,25 @@ HeuristicBase::logObj() const
            << "nan"    // gap
            << " 0 0 0" // violated constraints;
            << " 0 0 0" // termination/birth/bifuraction constr.
-           << " 0 0\n";
+           << " 0 0 0\n";
 
-    {
-        std::ofstream file(data_.solutionName + "-optimization-log.txt",
-                           std::ofstream::out | std::ofstream::app);
-        file << stream.str();
-        file.close();
-    }
+    data_.log.append(stream.str());
 
     data_.timer.start();
 }
 
+inline void
+openOptimizationLog(OptimizationLog& log, std::string const& solutionName)
+{
+    log.open(solutionName + "-optimization-log.txt");
+    log.append("time objBound objBest gap nSpaceCycle nSpaceTime nMorality "
+               "nTermination nBirth nBifurcation objValue time_separation "
+               "nProposals\n");
+}
+
 template <class DATA, class OPT, class SOL>
 void
-postOptimizationChecks(DATA const& data, OPT const& optimizer,
+postOptimizationChecks(DATA& data, OPT const& optimizer,
                        SOL const& solution)
 {
     // calculate costs.
@@ -111,37 +115,42 @@ postOptimizationChecks(DATA const& data, OPT const& optimizer,
                << "nan"     // gap
                << " 0 0 0"; // violated constraints;
         stream << " 0 0 0"; // termination/birth/bifuraction constr.
-        stream << " 0 0\n";
+        stream << " 0 0 0\n";
 
         std::cout << stream.str();
 
-        std::ofstream file(data.solutionName + "-optimization-log.txt",
-                           std::ofstream::out | std::ofstream::app);
-        file << stream.str();
-        file.close();
+        data.log.append(stream.str());
+        data.log.flush();
     }
 }
 
+/// options of the greedy lineage agglomeration (GLA, BGLA).
+struct GreedySettings
+{
+    bool incrementalReproposal{ false }; // see Data
+    size_t maxBatchSize{ 64 };           // BGLA only, see Data
+};
+
 template <class OPTIMIZER>
 Solution
 applyHeuristic(ProblemGraph const& problemGraph, double costTermination = .0,
                double costBirth = .0, bool enforceBifurcationConstraint = false,
-               std::string solutionName = "heuristic", size_t maxIter = 500)
+               std::string solutionName = "heuristic", size_t maxIter = 500,
+               OptimizationLog::Settings logSettings = {},
+               GreedySettings greedySettings = {})
 {
+    Data data(problemGraph);
 
     // create log file/replace existing log file with empty log file
-    {
-        std::ofstream file(solutionName + "-optimization-log.txt");
-        file << "time objBound objBest gap nSpaceCycle nSpaceTime nMorality "
-                "nTermination nBirth nBifurcation objValue time_separation\n";
-        file.close();
-    }
+    data.log.configure(logSettings);
+    openOptimizationLog(data.log, solutionName);
 
-    Data data(problemGraph);
     data.costBirth = costBirth;
     data.costTermination = costTermination;
     data.enforceBifurcationConstraint = enforceBifurcationConstraint;
     data.solutionName = solutionName;
+    data.incrementalReproposal = greedySettings.incrementalReproposal;
+    data.maxBatchSize = greedySettings.maxBatchSize;
 
     // define costs
     for (auto e : problemGraph.problem().edges)
@@ -169,29 +178,36 @@ applyHeuristic(ProblemGraph const& problemGraph, double costTermination = .0,
     return solution;
 }
 
+/// options of the partition optimizers (KLB).
+struct PartitionOptimizerSettings
+{
+    bool parallelBipartitions{ false }; // see improvePairsInParallel
+    size_t numberOfMoveCandidates{ 0 }; // see proposeMoveByGain, 0: all
+};
+
 template <class OPTIMIZER, class INITIALIZER>
 Solution
 applyInitializedHeuristic(
     ProblemGraph const& problemGraph, double costTermination = .0,
     double costBirth = .0, bool enforceBifurcationConstraint = false,
     std::string solutionName = "heuristic",
-    size_t maxDistance = std::numeric_limits<size_t>::max())
+    size_t maxDistance = std::numeric_limits<size_t>::max(),
+    OptimizationLog::Settings logSettings = {},
+    PartitionOptimizerSettings partitionSettings = {})
 {
+    Data data(problemGraph);
 
     // create log file/replace existing log file with empty log file
-    {
-        std::ofstream file(solutionName + "-optimization-log.txt");
-        file << "time objBound objBest gap nSpaceCycle nSpaceTime nMorality "
-                "nTermination nBirth nBifurcation objValue time_separation\n";
-        file.close();
-    }
+    data.log.configure(logSettings);
+    openOptimizationLog(data.log, solutionName);
 
-    Data data(problemGraph);
     data.costBirth = costBirth;
     data.costTermination = costTermination;
     data.enforceBifurcationConstraint = enforceBifurcationConstraint;
     data.solutionName = solutionName;
     data.maxDistance = maxDistance;
+    data.parallelBipartitions = partitionSettings.parallelBipartitions;
+    data.numberOfMoveCandidates = partitionSettings.numberOfMoveCandidates;
 
     // define costs
     for (auto e : problemGraph.problem().edges)
@@ -216,12 +232,7 @@ applyInitializedHeuristic(
     }
 
     // create log replace log of initializer with empty log file
-    {
-        std::ofstream file(solutionName + "-optimization-log.txt");
-        file << "time objBound objBest gap nSpaceCycle nSpaceTime nMorality "
-                "nTermination nBirth nBifurcation objValue time_separation\n";
-        file.close();
-    }
+    openOptimizationLog(data.log, solutionName);
 
     data.timer.start();
     auto search = OPTIMIZER(data, init);
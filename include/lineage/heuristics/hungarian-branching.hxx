@@ -1,11 +1,10 @@
 #pragma once
 
-#include <future>
+#include <queue>
 #include <vector>
 
-#include "andres/graph/digraph.hxx"
 #include "branching.hxx"
-#include "markurem/munkres.hxx"
+#include "sparse-assignment.hxx"
 
 namespace lineage {
 namespace heuristics {
@@ -42,10 +41,6 @@ private:
     Solution solution_;
 
     virtual void setup();
-
-    using cost_t = std::vector<double>;
-    using mask_t = std::vector<int>;
-    using bipartite_graph_t = andres::graph::Digraph<>;
 };
 
 template <class GRAPH>
@@ -72,142 +67,111 @@ template <class GRAPH>
 inline double
 HungarianBranching<GRAPH>::optimize()
 {
-    auto handles = std::vector<std::future<double>>();
-    for (size_t frame = 0;
-         frame < this->graph_.data_.problemGraph.numberOfFrames() - 1;
-         ++frame) {
-        handles.emplace_back(std::async(
-            std::launch::async, &HungarianBranching<GRAPH>::optimizeStep, this,
-            partitions_[frame], partitions_[frame + 1], true));
-    }
+    const auto numberOfSteps =
+        this->graph_.data_.problemGraph.numberOfFrames() - 1;
+
+    std::vector<double> objectives(numberOfSteps);
+    this->graph_.data_.threadPool->parallelFor(
+        numberOfSteps, [&](size_t frame) {
+            objectives[frame] = optimizeStep(partitions_[frame],
+                                             partitions_[frame + 1], true);
+        });
 
     double objective = .0;
-    for (auto& handle : handles)
-        objective += handle.get();
+    for (auto stepObjective : objectives)
+        objective += stepObjective;
 
     return objective;
 }
 
+/// assignment problem of the branching between the partitions first of
+/// frame t and second of frame t+1, with one row per partition of first,
+/// a duplicate thereof (for a second descendant) and a birth row per
+/// partition of second. Columns are the partitions of second followed by
+/// the termination of each row of first and its duplicate. second must be
+/// sorted. branchingEdges receives the edge of the graph that corresponds
+/// to each edge of the assignment, or SparseAssignment::none().
 template <class GRAPH>
-inline double
-HungarianBranching<GRAPH>::optimizeStep(std::vector<size_t> const& first,
-                                        std::vector<size_t> const& second,
-                                        bool mark_solution)
+void
+buildStepAssignment(GRAPH const& graph, std::vector<size_t> const& first,
+                    std::vector<size_t> const& second,
+                    SparseAssignment& assignment,
+                    std::vector<size_t>& branchingEdges)
 {
-    // setup cost for matching.
-    const size_t n_rows = 2 * first.size() + second.size();
-    const size_t n_cols = n_rows;
-
-    // lookup for auxiliary nodes.
     const size_t first_size = first.size();
     const size_t second_size = second.size();
-    auto idxOfRow = [=](size_t row) { return row; };
+    const size_t n_rows = 2 * first_size + second_size;
+
     auto idxOfDuplicateRow = [=](size_t row) { return first_size + row; };
     auto idxOfBirthRow = [=](size_t col) { return 2 * first_size + col; };
-    auto idxOfCol = [=](size_t col) { return n_rows + col; };
-    auto idxOfTerminationCol = [=](size_t row) {
-        return n_rows + second_size + row;
-    };
+    auto idxOfTerminationCol = [=](size_t row) { return second_size + row; };
 
-    // construct auxiliary graph for matching.
-    auto bigraph = bipartite_graph_t(n_rows + n_cols);
-    auto costs = cost_t();
-    auto mask = mask_t();
+    assignment.reset(n_rows, n_rows);
+    branchingEdges.clear();
 
-    auto setCost = [&](size_t row, size_t col, double val) {
-        bigraph.insertEdge(row, col);
-        costs.emplace_back(val);
-        mask.emplace_back(0);
+    auto setCost = [&](size_t row, size_t col, double val, size_t edge) {
+        assignment.addEdge(row, col, val);
+        branchingEdges.push_back(edge);
     };
 
-    for (size_t row = 0; row < first.size(); ++row) {
+    const auto none = SparseAssignment::none();
+    for (size_t row = 0; row < first_size; ++row) {
 
         auto const& partitionIdA = first[row];
 
         // termination costs.
-
-        setCost(idxOfRow(row), idxOfTerminationCol(row),
-                this->graph_.terminationCosts(partitionIdA));
+        setCost(row, idxOfTerminationCol(row),
+                graph.terminationCosts(partitionIdA), none);
         setCost(idxOfDuplicateRow(row),
-                idxOfTerminationCol(idxOfDuplicateRow(row)), .0);
+                idxOfTerminationCol(idxOfDuplicateRow(row)), .0, none);
 
-        for (auto it = this->graph_.verticesFromVertexBegin(partitionIdA);
-             it != this->graph_.verticesFromVertexEnd(partitionIdA); ++it) {
-            auto const& partitionIdB = *it;
+        for (auto it = graph.adjacenciesFromVertexBegin(partitionIdA);
+             it != graph.adjacenciesFromVertexEnd(partitionIdA); ++it) {
 
+            // if maxDistance is limited, then it might be that the edge is
+            // not found.
             const auto pos =
-                std::find(second.cbegin(), second.cend(), partitionIdB);
-            if (pos == second.cend()) { // if maxDistance is limited, then it
-                                        // might be that the edge is not found.
+                std::lower_bound(second.cbegin(), second.cend(), it->vertex());
+            if (pos == second.cend() || *pos != it->vertex())
                 continue;
-                // throw std::runtime_error(
-                //        "Could not find neighbouring partition in frame
-                //        t+1!");
-            }
-            const auto col = std::distance(second.cbegin(), pos);
 
-            const auto p = this->graph_.findEdge(partitionIdA, partitionIdB);
-            if (!p.first)
-                throw std::runtime_error("Could not find edge (A, B)!");
+            const size_t col = std::distance(second.cbegin(), pos);
+            auto const& coeff = graph.costOfEdge(it->edge());
 
-            auto const& coeff = this->graph_.costOfEdge(p.second);
-
-            setCost(idxOfRow(row), idxOfCol(col), coeff);
-            setCost(idxOfDuplicateRow(row), idxOfCol(col), coeff);
+            setCost(row, col, coeff, it->edge());
+            setCost(idxOfDuplicateRow(row), col, coeff, it->edge());
 
             // auxiliary edges.
-            setCost(idxOfBirthRow(col), idxOfTerminationCol(row), .0);
+            setCost(idxOfBirthRow(col), idxOfTerminationCol(row), .0, none);
             setCost(idxOfBirthRow(col),
-                    idxOfTerminationCol(idxOfDuplicateRow(row)), .0);
+                    idxOfTerminationCol(idxOfDuplicateRow(row)), .0, none);
         }
     }
 
     // birth costs.
-    for (size_t col = 0; col < second.size(); ++col) {
-        auto const& partitionIdB = second[col];
-        setCost(idxOfBirthRow(col), idxOfCol(col),
-                this->graph_.birthCosts(partitionIdB));
-    }
-
-    // Matching modifies the costs of the given vector, so we make a copy for
-    // objective calculation later on.
-    auto const original_costs = costs;
-
-    auto matcher =
-        markurem::matching::Matching<bipartite_graph_t, cost_t, mask_t>(
-            bigraph, costs, mask);
-    matcher.run();
+    for (size_t col = 0; col < second_size; ++col)
+        setCost(idxOfBirthRow(col), col, graph.birthCosts(second[col]), none);
+}
 
-    // calculate objective and mark edges.
-    double objective = .0;
-    auto const matches = matcher.matches();
+template <class GRAPH>
+inline double
+HungarianBranching<GRAPH>::optimizeStep(std::vector<size_t> const& first,
+                                        std::vector<size_t> const& second,
+                                        bool mark_solution)
+{
+    SparseAssignment assignment;
+    std::vector<size_t> branchingEdges;
+    buildStepAssignment(this->graph_, first, second, assignment,
+                        branchingEdges);
 
-    for (size_t idx = 0; idx < mask.size(); ++idx)
-        if (mask[idx] == 1)
-            objective += original_costs[idx];
+    const auto objective = assignment.solve();
 
+    // mark the edges between original nodes as matched in the solution.
     if (mark_solution) {
-        for (auto const& match : matches) {
-            // if the match involves to original nodes, then
-            // mark the edge as matched in the solution.
-            size_t partitionIdA, partitionIdB;
-            if (match.col >= second.size() + n_rows)
-                continue;
-            else
-                partitionIdB = second[match.col - n_rows];
-
-            if (match.row < first.size())
-                partitionIdA = first[match.row];
-            else if (match.row < 2 * first.size())
-                partitionIdA = first[match.row - first.size()];
-            else
-                continue;
-
-            auto p = this->graph_.findEdge(partitionIdA, partitionIdB);
-            if (!p.first)
-                throw std::runtime_error("Could not find matched edge!");
-
-            solution_[p.second] = true;
+        for (size_t row = 0; row < 2 * first.size(); ++row) {
+            const auto edge = branchingEdges[assignment.edgeOfRow(row)];
+            if (edge != SparseAssignment::none())
+                solution_[edge] = true;
         }
     }
 
@@ -367,25 +331,20 @@ MaskedHungarianBranching<GRAPH>::optimize()
     const auto centerFrame = this->getFrame(A_);
 
     // border cases where only one step has to be solved.
-    // We handle these separately to avoid unnecessary overhead
-    // from std::async.
     if (centerFrame == 0)
         return this->optimizeStep(second_, third_, false);
     if (centerFrame == this->getMaxFrame() - 1)
         return this->optimizeStep(first_, second_, false);
 
     // solve subproblem in {t-1,t} and {t,t+1} in parallel.
-    auto first_handle = std::async(
-        std::launch::async, &MaskedHungarianBranching<GRAPH>::optimizeStep,
-        this, first_, second_, false);
-
-    auto second_handle = std::async(
-        std::launch::async, &MaskedHungarianBranching<GRAPH>::optimizeStep,
-        this, second_, third_, false);
-
-    const auto objective = first_handle.get() + second_handle.get();
-
-    return objective;
+    double objectives[2];
+    this->getGraph().data_.threadPool->parallelFor(2, [&](size_t step) {
+        objectives[step] = step == 0
+                               ? this->optimizeStep(first_, second_, false)
+                               : this->optimizeStep(second_, third_, false);
+    });
+
+    return objectives[0] + objectives[1];
 }
 
 } // end namespace branching
@@ -0,0 +1,283 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_INCREMENTAL_BRANCHING_HXX
+#define LINEAGE_HEURISTICS_INCREMENTAL_BRANCHING_HXX
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lineage {
+namespace heuristics {
+namespace branching {
+
+/// Optimal branching of a partition graph under local changes.
+///
+/// The assignment problems of all pairs of consecutive frames (cf.
+/// buildStepAssignment) are kept as one sparse assignment with three rows
+/// and three columns per partition p:
+///
+///   row 3p:     p as a parent,      column 3p:     p as a child,
+///   row 3p + 1: p as a 2nd parent,  column 3p + 1: termination of row 3p,
+///   row 3p + 2: birth of p,         column 3p + 2: termination of row 3p+1.
+///
+/// The assignment and the dual potentials are kept between calls. touch(p)
+/// marks the rows whose edges depend on partition p. It has to be called
+/// before and after p changes (its nodes or its edges in the graph), such
+/// that rows of former as well as current neighbours are marked. objective()
+/// then unassigns the marked rows, rebuilds their edges from the graph and
+/// re-assigns them along shortest augmenting paths, starting from the
+/// potentials of the previous solution. The work is thus proportional to
+/// the change instead of the size of the graph.
+class IncrementalBranching
+{
+public:
+    static constexpr size_t none()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    /// make room for numberOfPartitions and mark all of them.
+    void resize(const size_t numberOfPartitions)
+    {
+        const auto n = 3 * numberOfPartitions;
+        if (n <= arcs_.size())
+            return;
+
+        const auto previous = arcs_.size();
+        arcs_.resize(n);
+        u_.resize(n, .0);
+        v_.resize(n, .0);
+        arcOfRow_.resize(n, none());
+        rowOfColumn_.resize(n, none());
+        marked_.resize(n, false);
+        distance_.resize(n, infinity());
+        predecessor_.resize(n);
+        scanned_.resize(n, false);
+
+        for (auto row = previous; row < n; ++row)
+            mark(row);
+    }
+
+    /// mark the rows that depend on partition p.
+    template <class GRAPH>
+    void touch(GRAPH const& graph, const size_t p)
+    {
+        mark(3 * p);
+        mark(3 * p + 1);
+        mark(3 * p + 2);
+
+        // parents have an edge to column 3p, children to the termination
+        // columns of p.
+        for (auto it = graph.verticesToVertexBegin(p);
+             it != graph.verticesToVertexEnd(p); ++it) {
+            mark(3 * *it);
+            mark(3 * *it + 1);
+        }
+
+        for (auto it = graph.verticesFromVertexBegin(p);
+             it != graph.verticesFromVertexEnd(p); ++it)
+            mark(3 * *it + 2);
+    }
+
+    /// objective of the optimal branching of graph.
+    template <class GRAPH>
+    double objective(GRAPH const& graph)
+    {
+        for (auto row : markedRows_)
+            unassign(row);
+
+        for (auto row : markedRows_) {
+            buildRow(graph, row);
+
+            u_[row] = infinity();
+            for (auto const& arc : arcs_[row])
+                u_[row] = std::min(u_[row], arc.cost - v_[arc.column]);
+        }
+
+        for (auto row : markedRows_) {
+            marked_[row] = false;
+            if (!arcs_[row].empty())
+                augment(row);
+        }
+        markedRows_.clear();
+
+        return objective_;
+    }
+
+private:
+    struct Arc
+    {
+        size_t column;
+        double cost;
+    };
+
+    using Entry = std::pair<double, size_t>; // distance, column
+
+    static constexpr double infinity()
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void mark(const size_t row)
+    {
+        if (row < marked_.size() && !marked_[row]) {
+            marked_[row] = true;
+            markedRows_.push_back(row);
+        }
+    }
+
+    void unassign(const size_t row)
+    {
+        const auto a = arcOfRow_[row];
+        if (a == none())
+            return;
+
+        objective_ -= arcs_[row][a].cost;
+        rowOfColumn_[arcs_[row][a].column] = none();
+        arcOfRow_[row] = none();
+    }
+
+    template <class GRAPH>
+    void buildRow(GRAPH const& graph, const size_t row)
+    {
+        auto& arcs = arcs_[row];
+        arcs.clear();
+
+        const auto p = row / 3;
+        if (graph.partitions_[p].empty())
+            return;
+
+        switch (row % 3) {
+            case 0:
+            case 1:
+                arcs.push_back({ row + 1, row % 3 == 0
+                                              ? graph.terminationCosts(p)
+                                              : .0 });
+                for (auto it = graph.adjacenciesFromVertexBegin(p);
+                     it != graph.adjacenciesFromVertexEnd(p); ++it)
+                    arcs.push_back(
+                        { 3 * it->vertex(), graph.costOfEdge(it->edge()) });
+                break;
+            default:
+                arcs.push_back({ 3 * p, graph.birthCosts(p) });
+                for (auto it = graph.verticesToVertexBegin(p);
+                     it != graph.verticesToVertexEnd(p); ++it) {
+                    arcs.push_back({ 3 * *it + 1, .0 });
+                    arcs.push_back({ 3 * *it + 2, .0 });
+                }
+        }
+    }
+
+    // assign the free row source along a shortest augmenting path, cf.
+    // SparseAssignment.
+    void augment(const size_t source)
+    {
+        const std::greater<Entry> compare;
+
+        heap_.clear();
+        touched_.clear();
+        path_.clear();
+
+        auto scanRow = [&](const size_t row, const double base) {
+            for (size_t a = 0; a < arcs_[row].size(); ++a) {
+                const auto column = arcs_[row][a].column;
+                const auto d =
+                    base + arcs_[row][a].cost - u_[row] - v_[column];
+
+                if (d < distance_[column] && !scanned_[column]) {
+                    if (distance_[column] == infinity())
+                        touched_.push_back(column);
+                    distance_[column] = d;
+                    predecessor_[column] = { row, a };
+                    heap_.emplace_back(d, column);
+                    std::push_heap(heap_.begin(), heap_.end(), compare);
+                }
+            }
+        };
+
+        scanRow(source, .0);
+
+        size_t sink = none();
+        double length = .0;
+        while (sink == none()) {
+            if (heap_.empty())
+                throw std::runtime_error("branching is infeasible.");
+
+            std::pop_heap(heap_.begin(), heap_.end(), compare);
+            const auto entry = heap_.back();
+            heap_.pop_back();
+
+            const auto column = entry.second;
+            if (entry.first > distance_[column] || scanned_[column])
+                continue;
+
+            path_.push_back(column);
+            scanned_[column] = true;
+
+            if (rowOfColumn_[column] == none()) {
+                sink = column;
+                length = entry.first;
+            } else {
+                scanRow(rowOfColumn_[column], entry.first);
+            }
+        }
+
+        for (auto column : path_) {
+            const auto slack = length - distance_[column];
+            v_[column] -= slack;
+            if (rowOfColumn_[column] != none())
+                u_[rowOfColumn_[column]] += slack;
+        }
+        u_[source] += length;
+
+        // flip the path.
+        for (auto column = sink;;) {
+            const auto row = predecessor_[column].first;
+            const auto a = predecessor_[column].second;
+            const auto previous = arcOfRow_[row];
+
+            if (previous != none())
+                objective_ -= arcs_[row][previous].cost;
+            objective_ += arcs_[row][a].cost;
+
+            arcOfRow_[row] = a;
+            rowOfColumn_[column] = row;
+
+            if (row == source)
+                break;
+            column = arcs_[row][previous].column;
+        }
+
+        for (auto column : touched_) {
+            distance_[column] = infinity();
+            scanned_[column] = false;
+        }
+    }
+
+    std::vector<std::vector<Arc>> arcs_; // by row
+    std::vector<double> u_;              // by row
+    std::vector<double> v_;              // by column
+    std::vector<size_t> arcOfRow_;
+    std::vector<size_t> rowOfColumn_;
+    double objective_{ .0 };
+
+    std::vector<bool> marked_;
+    std::vector<size_t> markedRows_;
+
+    // shortest path search.
+    std::vector<double> distance_;
+    std::vector<std::pair<size_t, size_t>> predecessor_; // row, arc
+    std::vector<Entry> heap_;
+    std::vector<bool> scanned_;
+    std::vector<size_t> touched_;
+    std::vector<size_t> path_;
+};
+
+} // namespace branching
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -0,0 +1,168 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_INDEXED_HEAP_HXX
+#define LINEAGE_HEURISTICS_INDEXED_HEAP_HXX
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lineage {
+namespace heuristics {
+
+/// Addressable d-ary heap.
+///
+/// Like std::priority_queue, top() is the largest element with respect to
+/// COMPARE. push() returns a handle through which the element can later be
+/// updated or erased. Handles of erased elements are recycled, such that
+/// the memory is proportional to the maximum number of elements that were
+/// contained at the same time.
+template <class T, class COMPARE = std::less<T>, size_t D = 4>
+class IndexedHeap
+{
+public:
+    using Handle = size_t;
+
+    static_assert(D >= 2, "heap arity must be at least 2.");
+
+    explicit IndexedHeap(COMPARE const& compare = COMPARE())
+      : compare_(compare)
+    {
+    }
+
+    bool empty() const { return heap_.empty(); }
+
+    size_t size() const { return heap_.size(); }
+
+    T const& top() const { return values_[heap_.front()]; }
+
+    Handle topHandle() const { return heap_.front(); }
+
+    T const& operator[](Handle handle) const { return values_[handle]; }
+
+    void reserve(size_t numberOfElements)
+    {
+        values_.reserve(numberOfElements);
+        positions_.reserve(numberOfElements);
+        heap_.reserve(numberOfElements);
+    }
+
+    Handle push(T const& value)
+    {
+        Handle handle;
+        if (free_.empty()) {
+            handle = values_.size();
+            values_.push_back(value);
+            positions_.push_back(0);
+        } else {
+            handle = free_.back();
+            free_.pop_back();
+            values_[handle] = value;
+        }
+
+        positions_[handle] = heap_.size();
+        heap_.push_back(handle);
+        siftUp(positions_[handle]);
+
+        return handle;
+    }
+
+    void update(Handle handle, T const& value)
+    {
+        values_[handle] = value;
+        siftDown(siftUp(positions_[handle]));
+    }
+
+    void erase(Handle handle)
+    {
+        const auto position = positions_[handle];
+        const auto last = heap_.back();
+        heap_.pop_back();
+        free_.push_back(handle);
+
+        if (last != handle) {
+            place(last, position);
+            siftDown(siftUp(position));
+        }
+    }
+
+    void pop()
+    {
+        if (empty())
+            throw std::runtime_error("cannot pop from an empty heap.");
+
+        erase(heap_.front());
+    }
+
+    void clear()
+    {
+        values_.clear();
+        positions_.clear();
+        heap_.clear();
+        free_.clear();
+    }
+
+private:
+    void place(Handle handle, size_t position)
+    {
+        heap_[position] = handle;
+        positions_[handle] = position;
+    }
+
+    // true if the element at handle a belongs above the one at handle b.
+    bool above(Handle a, Handle b) const
+    {
+        return compare_(values_[b], values_[a]);
+    }
+
+    size_t siftUp(size_t position)
+    {
+        const auto handle = heap_[position];
+        while (position > 0) {
+            const auto parent = (position - 1) / D;
+            if (!above(handle, heap_[parent]))
+                break;
+
+            place(heap_[parent], position);
+            position = parent;
+        }
+        place(handle, position);
+        return position;
+    }
+
+    size_t siftDown(size_t position)
+    {
+        const auto handle = heap_[position];
+        while (true) {
+            const auto first = D * position + 1;
+            if (first >= heap_.size())
+                break;
+
+            const auto end = std::min(first + D, heap_.size());
+            auto best = first;
+            for (auto child = first + 1; child < end; ++child)
+                if (above(heap_[child], heap_[best]))
+                    best = child;
+
+            if (!above(heap_[best], handle))
+                break;
+
+            place(heap_[best], position);
+            position = best;
+        }
+        place(handle, position);
+        return position;
+    }
+
+    COMPARE compare_;
+    std::vector<T> values_;        // by handle
+    std::vector<size_t> positions_; // by handle
+    std::vector<Handle> heap_;
+    std::vector<Handle> free_;
+};
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -3,14 +3,16 @@
 #define LINEAGE_HEURISTICS_PARTITION_GRAPH_HXX
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
-#include <stack>
-#include <unordered_set>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include "andres/graph/components.hxx"
 #include "andres/graph/digraph.hxx"
 
+#include "incremental-branching.hxx"
 #include "lineage/problem-graph.hxx"
 
 namespace lineage {
@@ -23,9 +25,21 @@ public:
     std::vector<bool> branchingLabels_;
 
     Data& data_;
-    std::vector<std::unordered_set<size_t>> partitions_;
+    /// nodes of each partition, in no particular order.
+    std::vector<std::vector<size_t>> partitions_;
     std::vector<size_t> vertexLabels_;
 
+    /// in-frame edges of the problem graph between two partitions.
+    struct Boundary
+    {
+        size_t numberOfEdges{ 0 };
+        double cost{ .0 }; // sum of data_.costs
+    };
+
+    /// partitions of the same frame that are connected by edges of the
+    /// problem graph, with the boundary to each.
+    std::vector<std::unordered_map<size_t, Boundary>> adjacentPartitions_;
+
     explicit PartitionGraph(Data& data)
       : data_(data)
     {
@@ -78,8 +92,25 @@ public:
 
         // construct partitions from initial labeling.
         partitions_.resize(numberOfComponents);
+        frameOfPartition_.resize(numberOfComponents);
+        positionInPartition_.resize(vertexLabels_.size());
         for (size_t v = 0; v < vertexLabels_.size(); ++v) {
-            partitions_[vertexLabels_[v]].insert(v);
+            insertNode(vertexLabels_[v], v);
+        }
+
+        adjacentPartitions_.resize(numberOfComponents);
+        cutVertexCaches_.resize(numberOfComponents);
+        for (size_t edge = 0; edge < data_.problemGraph.graph().numberOfEdges();
+             ++edge) {
+            const auto v0 = data_.problemGraph.graph().vertexOfEdge(edge, 0);
+            const auto v1 = data_.problemGraph.graph().vertexOfEdge(edge, 1);
+
+            if (data_.problemGraph.frameOfNode(v0) ==
+                    data_.problemGraph.frameOfNode(v1) &&
+                vertexLabels_[v0] != vertexLabels_[v1]) {
+                addAdjacency(vertexLabels_[v0], vertexLabels_[v1],
+                             data_.costs[edge]);
+            }
         }
 
         // construct vertices and edges of branching graph.
@@ -108,6 +139,7 @@ public:
                            -data_.costs[edge]); // negative costs because
                                                 // BranchingOptimizer
                                                 // *maximizes*
+            updateEdgeSupport(branchingEdgeId, 1);
         }
 
         // initialize with empty branching.
@@ -154,8 +186,7 @@ public:
                 "Partition is empty and thus not associated with a frame.");
         }
 
-        const auto anyVertexOfPartition = *partitions_[partitionId].cbegin();
-        return this->data_.problemGraph.frameOfNode(anyVertexOfPartition);
+        return frameOfPartition_[partitionId];
     }
 
     /// cost of edge for branching.
@@ -174,8 +205,7 @@ public:
         }
 
         // no birth cost in the first frame.
-        const auto anyVertexOfPartition = *partitions_[partitionId].cbegin();
-        if (data_.problemGraph.frameOfNode(anyVertexOfPartition) == 0) {
+        if (frameOfPartition_[partitionId] == 0) {
             return 0;
         } else {
             return partitions_[partitionId].size() * data_.costBirth;
@@ -190,8 +220,7 @@ public:
         }
 
         // no termination cost in the last frame.
-        const auto anyVertexOfPartition = *partitions_[partitionId].cbegin();
-        if (data_.problemGraph.frameOfNode(anyVertexOfPartition) ==
+        if (frameOfPartition_[partitionId] ==
             data_.problemGraph.numberOfFrames() - 1) {
             return 0;
         } else {
@@ -225,67 +254,28 @@ public:
         const size_t previousPartition = vertexLabels_[v];
 
         // make sure moving the node doesnt split the partition.
-        if (partitions_[previousPartition].size() > 2) {
-
-            std::stack<size_t> stack;
-
-            for (auto it = partitions_[previousPartition].cbegin();
-                 it != partitions_[previousPartition].cend(); ++it) {
-                if (*it != v) {
-                    stack.push(*it);
-                    break;
-                }
-            }
-
-            std::vector<bool> visited;
-            visited.resize(this->data_.problemGraph.graph().numberOfVertices(),
-                           false);
-
-            while (!stack.empty()) {
-                const auto w = stack.top();
-                stack.pop();
-
-                visited[w] = true;
-
-                for (auto it = this->data_.problemGraph.graph()
-                                   .adjacenciesFromVertexBegin(w);
-                     it !=
-                     this->data_.problemGraph.graph().adjacenciesFromVertexEnd(
-                         w);
-                     ++it) {
-                    if (it->vertex() == v)
-                        continue;
-                    if (visited[it->vertex()])
-                        continue;
-                    if (vertexLabels_[it->vertex()] == previousPartition)
-                        stack.push(it->vertex());
-                }
-            }
-
-            for (const auto& w : partitions_[previousPartition]) {
-                if (w == v) {
-                    continue;
-                }
-
-                // if it would break a partition, then dont move.
-                if (!visited[w]) {
-                    return std::numeric_limits<double>::infinity();
-                }
-            }
+        if (partitions_[previousPartition].size() > 2 &&
+            !remainsConnectedWithout(previousPartition, v)) {
+            return std::numeric_limits<double>::infinity();
         }
 
         if (targetPartition >= partitions_.size())
             throw std::runtime_error("Partition does not exist!");
 
+        touch(previousPartition);
+        touch(targetPartition);
+
         // move the node v to the same partition w.
-        partitions_[previousPartition].erase(v);
-        partitions_[targetPartition].insert(v);
+        eraseNode(previousPartition, v);
+        insertNode(targetPartition, v);
         vertexLabels_[v] = targetPartition;
+        updateCutVertexCaches(v, previousPartition, targetPartition);
 
         // calculate objective change in-plane and update costs for
         // the branching.
         auto objectiveChange = .0;
-        std::vector<size_t> buffer;
+        auto& buffer = edgeBuffer_;
+        buffer.clear();
         for (auto it =
                  this->data_.problemGraph.graph().adjacenciesFromVertexBegin(v);
              it != this->data_.problemGraph.graph().adjacenciesFromVertexEnd(v);
@@ -304,6 +294,9 @@ public:
                     objectiveChange -= this->data_.costs[it->edge()];
                 }
 
+                moveAdjacency(vertexLabels_[it->vertex()], previousPartition,
+                              targetPartition, this->data_.costs[it->edge()]);
+
             } else { // inter-frame.
                 size_t previousBranchingEdge, newBranchingEdge;
 
@@ -340,6 +333,8 @@ public:
                                -this->data_.costs[it->edge()]);
                 updateEdgeCost(previousBranchingEdge,
                                this->data_.costs[it->edge()]);
+                updateEdgeSupport(newBranchingEdge, 1);
+                updateEdgeSupport(previousBranchingEdge, -1);
 
                 // we will only need to check branching edges where the
                 // contributing edge of v was removed whether they vanished.
@@ -350,6 +345,13 @@ public:
         // check if we have to remove edges.
         removeVanishedEdges(buffer);
 
+        touch(previousPartition);
+        touch(targetPartition);
+
+#ifdef DEBUG
+        checkConsistency();
+#endif
+
         return objectiveChange;
     }
 
@@ -361,24 +363,43 @@ public:
         }
         const size_t previousPartition = vertexLabels_[v];
 
+        // edges are updated by updateEdgesOfPartition.
+        touch(previousPartition);
+        touch(partitionId);
+
+        cutVertexCaches_[previousPartition] = CutVertexCache();
+        cutVertexCaches_[partitionId] = CutVertexCache();
+
         // move the node v to the same partition w.
-        partitions_[previousPartition].erase(v);
-        partitions_[partitionId].insert(v);
+        eraseNode(previousPartition, v);
+        insertNode(partitionId, v);
         vertexLabels_[v] = partitionId;
+
+        auto const& graph = this->data_.problemGraph.graph();
+        for (auto it = graph.adjacenciesInFrameBegin(v);
+             it != graph.adjacenciesInFrameEnd(v); ++it)
+            moveAdjacency(vertexLabels_[it->vertex()], previousPartition,
+                          partitionId, this->data_.costs[it->edge()]);
     }
 
     void updateEdgesOfPartition(size_t partitionId)
     {
-        // reset weights and collect branching edges.
-        std::vector<size_t> buffer;
+        touch(partitionId);
+
+        // reset weights and collect branching edges. All edges of the
+        // problem graph that contribute to them are counted again below.
+        auto& buffer = edgeBuffer_;
+        buffer.clear();
         for (auto it = this->edgesFromVertexBegin(partitionId);
              it != this->edgesFromVertexEnd(partitionId); ++it) {
             branchingEdgeCosts_[*it] = 0;
+            branchingEdgeSupport_[*it] = 0;
             buffer.emplace_back(*it);
         }
         for (auto it = this->edgesToVertexBegin(partitionId);
              it != this->edgesToVertexEnd(partitionId); ++it) {
             branchingEdgeCosts_[*it] = 0;
+            branchingEdgeSupport_[*it] = 0;
             buffer.emplace_back(*it);
         }
 
@@ -409,22 +430,371 @@ public:
                         }
                         updateEdgeCost(branchingEdge,
                                        -this->data_.costs[it->edge()]);
+                        updateEdgeSupport(branchingEdge, 1);
                     }
                 }
             }
         }
         // Remove unvisited edges.
         removeVanishedEdges(buffer);
+
+        touch(partitionId);
     }
 
     // insert a new vertex and create a new set for its nodes.
     void addVertex()
     {
         insertVertex();
-        partitions_.emplace_back(std::unordered_set<size_t>());
+        partitions_.emplace_back();
+        frameOfPartition_.emplace_back(0);
+        adjacentPartitions_.emplace_back();
+        cutVertexCaches_.emplace_back();
+
+        if (incrementalBranchingEnabled_)
+            incrementalBranching_.resize(partitions_.size());
+    }
+
+    /// sum of the costs of the in-frame edges between two partitions.
+    double boundaryCost(const size_t a, const size_t b) const
+    {
+        const auto it = adjacentPartitions_[a].find(b);
+        return it == adjacentPartitions_[a].end() ? .0 : it->second.cost;
+    }
+
+    /// append the in-frame edges between two partitions as pairs of nodes
+    /// (v, w), v in a, w in b. Visits the nodes of the smaller partition.
+    void boundaryEdges(const size_t a, const size_t b,
+                       std::vector<std::pair<size_t, size_t>>& edges) const
+    {
+        if (adjacentPartitions_[a].count(b) == 0)
+            return;
+
+        const bool swapped = partitions_[b].size() < partitions_[a].size();
+        const auto from = swapped ? b : a;
+        const auto to = swapped ? a : b;
+
+        auto const& graph = this->data_.problemGraph.graph();
+        for (const auto v : partitions_[from])
+            for (auto it = graph.adjacenciesInFrameBegin(v);
+                 it != graph.adjacenciesInFrameEnd(v); ++it)
+                if (vertexLabels_[it->vertex()] == to) {
+                    if (swapped)
+                        edges.emplace_back(it->vertex(), v);
+                    else
+                        edges.emplace_back(v, it->vertex());
+                }
+    }
+
+    /// keep an optimal branching up to date under move, forceMove and
+    /// updateEdgesOfPartition, cf. branching::IncrementalBranching.
+    void enableIncrementalBranching()
+    {
+        incrementalBranchingEnabled_ = true;
+        incrementalBranching_.resize(partitions_.size());
+    }
+
+    /// objective of the optimal branching of the current partitions, as
+    /// the sum of HungarianBranching over all pairs of frames. The branching
+    /// is a cache that is repaired lazily, here, for the rows touched since
+    /// the last call. This modifies incrementalBranching_, so the function
+    /// must not be called concurrently on the same graph.
+    double incrementalBranchingObjective() const
+    {
+        if (!incrementalBranchingEnabled_)
+            throw std::runtime_error(
+                "Incremental branching is not enabled.");
+        return incrementalBranching_.objective(*this);
+    }
+
+    /// recompute the branching edges, their costs and their support from
+    /// the partitions and throw if they differ. Called after every move and
+    /// after the bipartitions of KLB if DEBUG is defined.
+    void checkConsistency() const
+    {
+        auto const& graph = this->data_.problemGraph.graph();
+
+        std::vector<double> costs(this->numberOfEdges(), .0);
+        std::vector<size_t> support(this->numberOfEdges(), 0);
+
+        for (size_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+            auto v0 = graph.vertexOfEdge(edge, 0);
+            auto v1 = graph.vertexOfEdge(edge, 1);
+
+            const auto f0 = this->data_.problemGraph.frameOfNode(v0);
+            const auto f1 = this->data_.problemGraph.frameOfNode(v1);
+
+            if (f0 == f1) {
+                continue;
+            }
+            if (f0 > f1) {
+                std::swap(v0, v1);
+            }
+
+            const auto p = this->findEdge(vertexLabels_[v0], vertexLabels_[v1]);
+            if (!p.first) {
+                throw std::runtime_error("Inconsistent edges: missing edge!");
+            }
+            costs[p.second] -= this->data_.costs[edge];
+            ++support[p.second];
+        }
+
+        for (size_t edge = 0; edge < this->numberOfEdges(); ++edge) {
+            if (support[edge] == 0) {
+                throw std::runtime_error("Inconsistent edges: vanished edge!");
+            }
+            if (support[edge] != branchingEdgeSupport_[edge]) {
+                throw std::runtime_error("Inconsistent edges: support!");
+            }
+            if (std::abs(costs[edge] - branchingEdgeCosts_[edge]) > 1e-6) {
+                throw std::runtime_error("Inconsistent edges: cost!");
+            }
+        }
     }
 
 private:
+    void insertNode(const size_t partitionId, const size_t v)
+    {
+        auto& partition = partitions_[partitionId];
+        if (partition.empty()) {
+            frameOfPartition_[partitionId] =
+                this->data_.problemGraph.frameOfNode(v);
+        }
+
+        positionInPartition_[v] = partition.size();
+        partition.push_back(v);
+    }
+
+    // O(1), the last node of the partition takes the place of v.
+    void eraseNode(const size_t partitionId, const size_t v)
+    {
+        auto& partition = partitions_[partitionId];
+        const auto last = partition.back();
+
+        partition[positionInPartition_[v]] = last;
+        positionInPartition_[last] = positionInPartition_[v];
+        partition.pop_back();
+    }
+
+    /// cut vertices of the subgraph induced by a partition, valid as long
+    /// as the partition is unchanged up to one node that was moved in or
+    /// out since (e.g. by a move that is undone next).
+    struct CutVertexCache
+    {
+        enum State : char
+        {
+            invalid,
+            valid,
+            disconnected
+        };
+
+        State state{ invalid };
+        size_t pending{ std::numeric_limits<size_t>::max() };
+        bool pendingAdded{ false };
+        bool pendingIsCutVertex{ false }; // isCutVertex_ is shared.
+    };
+
+    // true if the partition minus node v is connected.
+    bool remainsConnectedWithout(const size_t partitionId, const size_t v)
+    {
+        auto& cache = cutVertexCaches_[partitionId];
+        const auto none = std::numeric_limits<size_t>::max();
+
+        if (cache.state == CutVertexCache::valid && cache.pending == v &&
+            cache.pendingAdded) {
+            return true;
+        }
+
+        if (cache.state == CutVertexCache::valid && cache.pending != none) {
+            cache = CutVertexCache();
+        }
+
+        if (cache.state == CutVertexCache::invalid) {
+            cache.state = findCutVertices(partitionId)
+                              ? CutVertexCache::valid
+                              : CutVertexCache::disconnected;
+        }
+
+        if (cache.state == CutVertexCache::valid) {
+            return !isCutVertex_[v];
+        }
+
+        // depth first search in the partition, avoiding v.
+        auto const& graph = this->data_.problemGraph.graph();
+        const auto epoch = nextEpoch();
+
+        size_t start = none;
+        for (const auto w : partitions_[partitionId]) {
+            if (w != v) {
+                start = w;
+                break;
+            }
+        }
+
+        size_t numberOfVisited = 1;
+        visited_[start] = epoch;
+        dfsStack_.assign(1, start);
+        while (!dfsStack_.empty()) {
+            const auto w = dfsStack_.back();
+            dfsStack_.pop_back();
+
+            for (auto it = graph.adjacenciesInFrameBegin(w);
+                 it != graph.adjacenciesInFrameEnd(w); ++it) {
+                const auto u = it->vertex();
+                if (u != v && visited_[u] != epoch &&
+                    vertexLabels_[u] == partitionId) {
+                    visited_[u] = epoch;
+                    dfsStack_.push_back(u);
+                    ++numberOfVisited;
+                }
+            }
+        }
+
+        return numberOfVisited + 1 == partitions_[partitionId].size();
+    }
+
+    // Hopcroft-Tarjan on the subgraph induced by the partition. Unlike
+    // andres::graph::findCutVertices, the buffers are not cleared for the
+    // entire problem graph. Returns false if the partition is disconnected.
+    bool findCutVertices(const size_t partitionId)
+    {
+        auto const& graph = this->data_.problemGraph.graph();
+        const auto epoch = nextEpoch();
+
+        const auto root = *partitions_[partitionId].cbegin();
+        size_t numberOfVisited = 1;
+        size_t numberOfRootChildren = 0;
+
+        visited_[root] = epoch;
+        depth_[root] = 0;
+        low_[root] = 0;
+        nextNeighbour_[root] = 0;
+        isCutVertex_[root] = false;
+        dfsStack_.assign(1, root);
+
+        while (!dfsStack_.empty()) {
+            const auto v = dfsStack_.back();
+
+            const auto next =
+                graph.adjacenciesInFrameBegin(v) + nextNeighbour_[v];
+            if (next != graph.adjacenciesInFrameEnd(v)) {
+                const auto w = next->vertex();
+                ++nextNeighbour_[v];
+
+                if (vertexLabels_[w] != partitionId) {
+                    continue;
+                }
+
+                if (visited_[w] == epoch) {
+                    low_[v] = std::min(low_[v], depth_[w]);
+                } else {
+                    visited_[w] = epoch;
+                    depth_[w] = depth_[v] + 1;
+                    low_[w] = depth_[w];
+                    nextNeighbour_[w] = 0;
+                    isCutVertex_[w] = false;
+                    dfsStack_.push_back(w);
+                    ++numberOfVisited;
+                }
+            } else {
+                dfsStack_.pop_back();
+                if (dfsStack_.empty()) {
+                    break;
+                }
+
+                const auto parent = dfsStack_.back();
+                low_[parent] = std::min(low_[parent], low_[v]);
+
+                if (parent == root) {
+                    ++numberOfRootChildren;
+                } else if (low_[v] >= depth_[parent]) {
+                    isCutVertex_[parent] = true;
+                }
+            }
+        }
+
+        isCutVertex_[root] = numberOfRootChildren > 1;
+
+        return numberOfVisited == partitions_[partitionId].size();
+    }
+
+    void updateCutVertexCaches(const size_t v, const size_t previous,
+                               const size_t target)
+    {
+        const auto none = std::numeric_limits<size_t>::max();
+
+        for (const auto partitionId : { previous, target }) {
+            auto& cache = cutVertexCaches_[partitionId];
+            const bool added = partitionId == target;
+
+            if (cache.state != CutVertexCache::valid) {
+                cache = CutVertexCache();
+            } else if (cache.pending == none) {
+                cache.pending = v;
+                cache.pendingAdded = added;
+                cache.pendingIsCutVertex = isCutVertex_[v];
+            } else if (cache.pending == v && cache.pendingAdded != added) {
+                cache.pending = none;
+                if (added) {
+                    isCutVertex_[v] = cache.pendingIsCutVertex;
+                }
+            } else {
+                cache = CutVertexCache();
+            }
+        }
+    }
+
+    // stamps for visited_, which is thus never cleared.
+    size_t nextEpoch()
+    {
+        const auto numberOfNodes =
+            this->data_.problemGraph.graph().numberOfVertices();
+        if (visited_.size() != numberOfNodes) {
+            visited_.assign(numberOfNodes, 0);
+            depth_.resize(numberOfNodes);
+            low_.resize(numberOfNodes);
+            nextNeighbour_.resize(numberOfNodes);
+            isCutVertex_.resize(numberOfNodes);
+        }
+        return ++epoch_;
+    }
+
+    void touch(const size_t partitionId)
+    {
+        if (incrementalBranchingEnabled_)
+            incrementalBranching_.touch(*this, partitionId);
+    }
+
+    // an in-frame edge between partition and another node moved from
+    // partition previous to partition target.
+    void moveAdjacency(const size_t partition, const size_t previous,
+                       const size_t target, const double cost)
+    {
+        if (partition != previous)
+            removeAdjacency(partition, previous, cost);
+        if (partition != target)
+            addAdjacency(partition, target, cost);
+    }
+
+    void addAdjacency(const size_t a, const size_t b, const double cost)
+    {
+        for (const auto& pair : { std::make_pair(a, b), std::make_pair(b, a) }) {
+            auto& boundary = adjacentPartitions_[pair.first][pair.second];
+            ++boundary.numberOfEdges;
+            boundary.cost += cost;
+        }
+    }
+
+    void removeAdjacency(const size_t a, const size_t b, const double cost)
+    {
+        for (const auto& pair : { std::make_pair(a, b), std::make_pair(b, a) }) {
+            auto it = adjacentPartitions_[pair.first].find(pair.second);
+            if (--it->second.numberOfEdges == 0)
+                adjacentPartitions_[pair.first].erase(it);
+            else
+                it->second.cost -= cost;
+        }
+    }
+
     template <class T>
     void removeVanishedEdges(T&& buffer)
     {
@@ -434,32 +804,59 @@ private:
         auto last = std::unique(std::begin(buffer), std::end(buffer));
         buffer.erase(last, buffer.end());
 
+        // in descending order, such that eraseEdge only moves edges that
+        // have been checked already.
         for (auto it = buffer.crbegin(); it != buffer.crend(); ++it) {
-
-            bool exists = false;
-            for (const auto& a : partitions_[this->vertexOfEdge(*it, 0)]) {
-                for (const auto& b : partitions_[this->vertexOfEdge(*it, 1)]) {
-                    if (this->data_.problemGraph.graph().findEdge(a, b).first) {
-                        exists = true;
-                        break;
-                    }
-                }
-            }
-
-            if (!exists) {
+            if (branchingEdgeSupport_[*it] == 0) {
                 removeEdge(*it);
             }
         }
     }
 
+    void updateEdgeSupport(const size_t edgeId, const int delta)
+    {
+        if (edgeId >= branchingEdgeSupport_.size()) {
+            branchingEdgeSupport_.resize(edgeId + 1, 0);
+        }
+        branchingEdgeSupport_[edgeId] += delta;
+    }
+
     void removeEdge(const size_t edge)
     {
         // swap costs to account for the way eraseEdge works.
         const auto movingIdx = branchingEdgeCosts_.size() - 1;
         std::swap(branchingEdgeCosts_[edge], branchingEdgeCosts_[movingIdx]);
         branchingEdgeCosts_.pop_back();
+        std::swap(branchingEdgeSupport_[edge],
+                  branchingEdgeSupport_[movingIdx]);
+        branchingEdgeSupport_.pop_back();
         this->eraseEdge(edge);
     }
+
+    bool incrementalBranchingEnabled_{ false };
+
+    // lazily repaired by incrementalBranchingObjective(), which is const as
+    // it does not change the partitions.
+    mutable branching::IncrementalBranching incrementalBranching_;
+
+    // number of edges of the problem graph that contribute to each
+    // branching edge. An edge vanishes when this drops to 0.
+    std::vector<size_t> branchingEdgeSupport_;
+
+    std::vector<size_t> frameOfPartition_;    // valid if not empty.
+    std::vector<size_t> positionInPartition_; // by node.
+
+    std::vector<CutVertexCache> cutVertexCaches_; // by partition
+
+    // scratch, by node of the problem graph.
+    std::vector<size_t> visited_;
+    std::vector<size_t> depth_;
+    std::vector<size_t> low_;
+    std::vector<size_t> nextNeighbour_;
+    std::vector<char> isCutVertex_;
+    std::vector<size_t> dfsStack_;
+    std::vector<size_t> edgeBuffer_;
+    size_t epoch_{ 0 };
 };
 
 } // end namespace heuristics
@@ -2,12 +2,16 @@
 #ifndef LINEAGE_HEURISTICS_PARTITION_HXX
 #define LINEAGE_HEURISTICS_PARTITION_HXX
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <utility>
 #include <vector>
 //
 #include "heuristic-base.hxx"
+#include "indexed-heap.hxx"
 #include "partition-graph.hxx"
+#include "temporal-decomposition.hxx"
 
 namespace lineage {
 namespace heuristics {
@@ -39,6 +43,8 @@ public:
       , swapped_(data.problemGraph.graph().numberOfVertices(), false)
       , visited_(data.problemGraph.graph().numberOfVertices(), false)
       , bestVertexLabels_(partitionGraph_.vertexLabels_)
+      , moveGains_(data.problemGraph.graph().numberOfVertices(), .0)
+      , gainHandles_(data.problemGraph.graph().numberOfVertices(), noHandle())
     {
         // initialize internal objective.
         for (size_t edge = 0;
@@ -73,6 +79,14 @@ public:
     Solution getSolution() override;
     Cost getObjective() const override;
 
+    /// restrict the first pass of optimize() to the partitions of the frames
+    /// t with frames[t] == true. Other partitions are only revisited once a
+    /// move changes a partition connected to them by a branching edge.
+    void setInitialFrames(std::vector<bool> frames)
+    {
+        initialFrames_ = std::move(frames);
+    }
+
 protected:
     double solveFullBranchingProblem() const;
     double getBranchingObjective() const;
@@ -104,14 +118,41 @@ private:
         Cost obj_{ std::numeric_limits<Cost>::infinity() };
     };
 
+    /// moves of improvePairsOfFrame, to be applied by
+    /// improvePairsInParallel.
+    struct FrameMoves
+    {
+        size_t numberOfMoves_{ 0 };
+        std::vector<std::pair<size_t, size_t>> labels_; // node, partition
+        std::vector<size_t> changed_;                   // partitions
+        Cost dInternalObj_{ .0 };
+        Cost dBranchingObj_{ .0 };
+    };
+
     size_t improvePartitions();
+    size_t improveAdjacentPairs();
+    size_t improvePairsInParallel();
+    FrameMoves improvePairsOfFrame(size_t t) const;
+    void applyFrameMoves(FrameMoves const& moves);
     size_t improveBipartition(size_t v, size_t w);
     size_t splitPartition(size_t v);
     Move proposeSingleMove(size_t vertex, size_t other);
+    Move proposeMoveByGain(size_t partitionA, size_t partitionB,
+                           size_t numberOfCandidates);
+    double inFrameGain(size_t vertex, size_t partitionA,
+                       size_t partitionB) const;
+    void initializeMoveGains(
+        size_t partitionA, size_t partitionB,
+        std::vector<std::pair<size_t, size_t>> const& boundary);
+    void updateMoveGains(size_t vertex, size_t partitionA, size_t partitionB);
+    void restoreMoveCandidates();
     void applySingleMove(size_t vertex, size_t partitionId);
     void applyMerge(size_t partitionA, size_t partitionB);
 
     void solveFullBranchingProblemAndUpdateLabels();
+    /// optimizer of the same type for another problem.
+    virtual std::unique_ptr<PartitionOptimizerBase> create(
+        Data& data, Solution const& solution) const = 0;
     virtual double solveLocalBranchingProblem(size_t partitionIdA,
                                               size_t partitionIdB) const = 0;
     virtual double getBaselineBranchingObjective(size_t partitionIdA,
@@ -133,6 +174,19 @@ private:
     std::vector<bool> changed_;
     std::vector<bool> needsUpdate_;
     std::vector<size_t> bestVertexLabels_;
+    std::vector<bool> initialFrames_;
+
+    // moves ranked by in-frame gain, see proposeMoveByGain.
+    using GainHeap = IndexedHeap<std::pair<double, size_t>>; // gain, node
+    static constexpr size_t noHandle()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    std::vector<double> moveGains_;   // by node
+    GainHeap gainHeap_;               // one entry per node at most
+    std::vector<size_t> gainHandles_; // by node, noHandle() if not in heap
+    std::vector<size_t> moveCandidates_; // popped, to be pushed again
 };
 
 template <class BROPT>
@@ -212,21 +266,33 @@ PartitionOptimizerBase<BROPT>::optimize()
     size_t iter = 0;
 
     // progress output.
-    std::cout << "[" << getMethodName() << "] starting to optimize partitions. "
-              << std::endl;
+    if (!silent_) {
+        std::cout << "[" << getMethodName()
+                  << "] starting to optimize partitions. " << std::endl;
 
-    std::cout << std::endl
-              << std::setw(5) << "iter" << std::setw(WIDTH) << "obj"
-              << std::setw(WIDTH) << "delta" << std::setw(WIDTH) << "moves"
-              << std::setw(WIDTH) << "changed" << std::endl;
+        std::cout << std::endl
+                  << std::setw(5) << "iter" << std::setw(WIDTH) << "obj"
+                  << std::setw(WIDTH) << "delta" << std::setw(WIDTH) << "moves"
+                  << std::setw(WIDTH) << "changed" << std::endl;
 
-    std::cout << std::setw(5) << iter++ << std::setw(WIDTH) << getObjective()
-              << std::setw(2 * WIDTH) << " ";
+        std::cout << std::setw(5) << iter++ << std::setw(WIDTH)
+                  << getObjective() << std::setw(2 * WIDTH) << " ";
+    }
 
-    // consider all partitions changed for now.
+    // consider all partitions (of the initial frames) changed for now.
     changed_.resize(partitionGraph_.numberOfVertices(), true);
     needsUpdate_.resize(partitionGraph_.numberOfVertices());
 
+    if (!initialFrames_.empty()) {
+        for (size_t partition = 0;
+             partition < partitionGraph_.numberOfVertices(); ++partition) {
+            if (!partitionGraph_.partitions_[partition].empty()) {
+                const auto t = partitionGraph_.frameOfPartition(partition);
+                changed_[partition] = initialFrames_[t];
+            }
+        }
+    }
+
     while (progress) {
         const auto previous = getObjective();
 
@@ -240,15 +306,19 @@ PartitionOptimizerBase<BROPT>::optimize()
         const auto dObj = getObjective() - previous;
         progress = lowerThanWithEpsilon(previous, getObjective());
 
-        std::cout << std::setw(5) << iter++ << std::setw(WIDTH)
-                  << getObjective() << std::setw(WIDTH) << dObj
-                  << std::setw(WIDTH) << numberOfMoves;
-        if (!progress) {
-            std::cout << "*" << std::endl;
+        if (!silent_) {
+            std::cout << std::setw(5) << iter++ << std::setw(WIDTH)
+                      << getObjective() << std::setw(WIDTH) << dObj
+                      << std::setw(WIDTH) << numberOfMoves;
+            if (!progress) {
+                std::cout << "*" << std::endl;
+            }
         }
     }
 
-    std::cout << std::endl << std::endl;
+    if (!silent_) {
+        std::cout << std::endl << std::endl;
+    }
 }
 
 template <class BROPT>
@@ -263,49 +333,18 @@ PartitionOptimizerBase<BROPT>::improvePartitions()
         changed_[idx] = false;
     }
 
-    {
+    if (!silent_) {
         // complete info line.
         const auto numberOfUpdatedCells =
             std::accumulate(needsUpdate_.cbegin(), needsUpdate_.cend(), 0);
         std::cout << std::setw(WIDTH) << numberOfUpdatedCells << std::endl;
     }
 
-    for (size_t partitionA = 0;
-         partitionA < partitionGraph_.numberOfVertices() - 1; ++partitionA) {
-
-        for (size_t partitionB = partitionA + 1;
-             partitionB < partitionGraph_.numberOfVertices(); ++partitionB) {
-
-            if (partitionGraph_.partitions_[partitionA].empty())
-                break;
-            if (partitionGraph_.partitions_[partitionB].empty())
-                continue;
-
-            // check if "dirty"
-            if (!needsUpdate_[partitionA] && !needsUpdate_[partitionB]) {
-                continue;
-            }
-
-            // check whether the partitions are in the same frame.
-            // proximity (i.e. presence of an edge between them) will be
-            // tested
-            // implicitly in improveBipartition.
-            if (partitionGraph_.frameOfPartition(partitionA) !=
-                partitionGraph_.frameOfPartition(partitionB)) {
-                continue;
-            }
-
-            const auto additionalMoves =
-                improveBipartition(partitionA, partitionB);
-
-            if (additionalMoves > 0) {
-                changed_[partitionA] = true;
-                changed_[partitionB] = true;
-                numberOfMoves += additionalMoves;
-
-                this->logObj();
-            }
-        }
+    if (this->data_.parallelBipartitions &&
+        this->data_.threadPool->numberOfThreads() > 1) {
+        numberOfMoves += improvePairsInParallel();
+    } else {
+        numberOfMoves += improveAdjacentPairs();
     }
 
     // introduce new partitions.
@@ -356,6 +395,239 @@ PartitionOptimizerBase<BROPT>::improvePartitions()
     return numberOfMoves;
 }
 
+/// improveBipartition for the adjacent partitions of which one needs an
+/// update.
+template <class BROPT>
+inline size_t
+PartitionOptimizerBase<BROPT>::improveAdjacentPairs()
+{
+    size_t numberOfMoves = 0;
+
+    // pairs of partitions (A, B), A < B, in the same frame that are
+    // connected by an edge, in lexicographic order. B is looked up after
+    // each bipartition, as moves change the neighbours of A.
+    for (size_t partitionA = 0;
+         partitionA < partitionGraph_.numberOfVertices(); ++partitionA) {
+
+        auto const& adjacent = partitionGraph_.adjacentPartitions_[partitionA];
+        for (size_t partitionB = partitionA;;) {
+            auto next = std::numeric_limits<size_t>::max();
+            for (const auto& neighbour : adjacent)
+                if (neighbour.first > partitionB)
+                    next = std::min(next, neighbour.first);
+
+            if (next == std::numeric_limits<size_t>::max())
+                break;
+            partitionB = next;
+
+            // check if "dirty"
+            if (!needsUpdate_[partitionA] && !needsUpdate_[partitionB]) {
+                continue;
+            }
+
+            const auto additionalMoves =
+                improveBipartition(partitionA, partitionB);
+
+            if (additionalMoves > 0) {
+                changed_[partitionA] = true;
+                changed_[partitionB] = true;
+                numberOfMoves += additionalMoves;
+
+                this->logObj();
+            }
+        }
+    }
+
+    return numberOfMoves;
+}
+
+/// improveAdjacentPairs with frames improved concurrently.
+///
+/// Moves between the partitions of frame t only change the branching between
+/// the frames t - 1, t and t + 1. improvePairsOfFrame thus improves the pairs
+/// of frame t on a copy of these frames, which only reads the partition
+/// graph, and the frames of the same parity are improved concurrently: first
+/// the even, then the odd frames. The moves of each frame are applied once,
+/// in the order of the frames. Branching gains are the same as for the
+/// partition graph, and the result does not depend on the number of threads.
+template <class BROPT>
+inline size_t
+PartitionOptimizerBase<BROPT>::improvePairsInParallel()
+{
+    const auto numberOfFrames = this->data_.problemGraph.numberOfFrames();
+
+    std::vector<bool> needsUpdate(numberOfFrames, false);
+    for (size_t partition = 0; partition < partitionGraph_.numberOfVertices();
+         ++partition) {
+        if (needsUpdate_[partition] &&
+            !partitionGraph_.partitions_[partition].empty()) {
+            needsUpdate[partitionGraph_.frameOfPartition(partition)] = true;
+        }
+    }
+
+    size_t numberOfMoves = 0;
+    std::vector<size_t> frames;
+    std::vector<FrameMoves> moves;
+    for (size_t parity = 0; parity < 2; ++parity) {
+        frames.clear();
+        for (size_t t = parity; t < numberOfFrames; t += 2) {
+            if (needsUpdate[t]) {
+                frames.push_back(t);
+            }
+        }
+
+        moves.assign(frames.size(), FrameMoves());
+        this->data_.threadPool->parallelFor(
+            frames.size(),
+            [&](const size_t i) { moves[i] = improvePairsOfFrame(frames[i]); });
+
+        for (const auto& frameMoves : moves) {
+            if (frameMoves.numberOfMoves_ > 0) {
+                applyFrameMoves(frameMoves);
+                numberOfMoves += frameMoves.numberOfMoves_;
+
+                this->logObj();
+            }
+        }
+    }
+
+    return numberOfMoves;
+}
+
+/// improveAdjacentPairs for the partitions of frame t, by an optimizer of
+/// the same type for the frames t - 1 to t + 1.
+template <class BROPT>
+inline typename PartitionOptimizerBase<BROPT>::FrameMoves
+PartitionOptimizerBase<BROPT>::improvePairsOfFrame(const size_t t) const
+{
+    auto const& problemGraph = this->data_.problemGraph;
+
+    detail::TemporalBlock window;
+    window.first = t > 0 ? t - 1 : 0;
+    window.last = std::min(t + 2, problemGraph.numberOfFrames());
+    window.coreFirst = t;
+    window.coreLast = t + 1;
+    detail::extractBlock(problemGraph, window);
+
+    // nodes by node of the window.
+    std::vector<size_t> nodes;
+    nodes.reserve(window.problem.nodes.size());
+    for (size_t frame = window.first; frame < window.last; ++frame) {
+        for (size_t j = 0; j < problemGraph.numberOfNodesInFrame(frame); ++j) {
+            nodes.push_back(problemGraph.nodeInFrame(frame, j));
+        }
+    }
+
+    // the current partitions, by cut in-frame edges.
+    Solution solution;
+    solution.edge_labels.reserve(window.edges.size());
+    for (const auto edge : window.edges) {
+        const auto v0 = problemGraph.graph().vertexOfEdge(edge, 0);
+        const auto v1 = problemGraph.graph().vertexOfEdge(edge, 1);
+        solution.edge_labels.push_back(
+            problemGraph.frameOfNode(v0) != problemGraph.frameOfNode(v1) ||
+            partitionGraph_.vertexLabels_[v0] !=
+                partitionGraph_.vertexLabels_[v1]);
+    }
+
+    ProblemGraph windowGraph(window.problem);
+    Data data(windowGraph);
+
+    OptimizationLog::Settings logSettings;
+    logSettings.enabled = false;
+    data.log.configure(logSettings);
+
+    data.costBirth = this->data_.costBirth;
+    data.costTermination = this->data_.costTermination;
+    data.enforceBifurcationConstraint =
+        this->data_.enforceBifurcationConstraint;
+    data.maxDistance = this->data_.maxDistance;
+    data.numberOfMoveCandidates = this->data_.numberOfMoveCandidates;
+    data.threadPool = this->data_.threadPool;
+
+    for (const auto edge : window.edges)
+        data.costs.push_back(this->data_.costs[edge]);
+
+    if (data.costTermination > 0.0)
+        data.costs.insert(data.costs.end(), nodes.size(),
+                          data.costTermination);
+
+    if (data.costBirth > 0.0)
+        data.costs.insert(data.costs.end(), nodes.size(), data.costBirth);
+
+    auto optimizer = create(data, solution);
+    optimizer->setSilent(true);
+
+    // partitions by partition of the window, of which those in frame t are
+    // improved if they need an update.
+    auto const& partitions = optimizer->partitionGraph_;
+    const auto numberOfPartitions = partitions.numberOfVertices();
+
+    std::vector<size_t> partitionOf(numberOfPartitions);
+    optimizer->changed_.assign(numberOfPartitions, false);
+    optimizer->needsUpdate_.assign(numberOfPartitions, false);
+    for (size_t partition = 0; partition < numberOfPartitions; ++partition) {
+        const auto v = nodes[partitions.partitions_[partition].front()];
+        partitionOf[partition] = partitionGraph_.vertexLabels_[v];
+
+        if (problemGraph.frameOfNode(v) == t) {
+            optimizer->needsUpdate_[partition] =
+                needsUpdate_[partitionOf[partition]];
+        }
+    }
+
+    const auto internalObjective = optimizer->internalObjective_;
+    const auto branchingObjective = optimizer->branchingObjective_;
+
+    FrameMoves moves;
+    moves.numberOfMoves_ = optimizer->improveAdjacentPairs();
+    if (moves.numberOfMoves_ == 0) {
+        return moves;
+    }
+
+    for (size_t v = 0; v < nodes.size(); ++v) {
+        const auto partition = partitionOf[partitions.vertexLabels_[v]];
+        if (partition != partitionGraph_.vertexLabels_[nodes[v]]) {
+            moves.labels_.emplace_back(nodes[v], partition);
+        }
+    }
+
+    for (size_t partition = 0; partition < numberOfPartitions; ++partition) {
+        if (optimizer->changed_[partition]) {
+            moves.changed_.push_back(partitionOf[partition]);
+        }
+    }
+
+    moves.dInternalObj_ = optimizer->internalObjective_ - internalObjective;
+    moves.dBranchingObj_ = optimizer->branchingObjective_ - branchingObjective;
+
+    return moves;
+}
+
+/// apply the moves of improvePairsOfFrame.
+template <class BROPT>
+inline void
+PartitionOptimizerBase<BROPT>::applyFrameMoves(FrameMoves const& moves)
+{
+    // bestVertexLabels_ is where improveBipartition reverts to.
+    for (const auto& label : moves.labels_) {
+        partitionGraph_.forceMove(label.first, label.second);
+        bestVertexLabels_[label.first] = label.second;
+    }
+
+    for (const auto partition : moves.changed_) {
+        partitionGraph_.updateEdgesOfPartition(partition);
+        changed_[partition] = true;
+    }
+
+#ifdef DEBUG
+    partitionGraph_.checkConsistency();
+#endif
+
+    internalObjective_ += moves.dInternalObj_;
+    branchingObjective_ += moves.dBranchingObj_;
+}
+
 /// exchange nodes between the two partitions or merge them.
 ///
 template <class BROPT>
@@ -373,29 +645,39 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
     auto& partitionA = partitionGraph_.partitions_[partitionIdA];
     auto& partitionB = partitionGraph_.partitions_[partitionIdB];
 
-    // find moves.
+    // find moves, i.e. both directions of the edges between A and B.
     std::vector<std::pair<size_t, size_t>> move_edges;
-    for (const auto v : partitionA) {
-        for (const auto w : partitionB) {
+    std::vector<std::pair<size_t, size_t>> boundary;
+    auto findMoveEdges = [&]() {
+        boundary.clear();
+        partitionGraph_.boundaryEdges(partitionIdA, partitionIdB, boundary);
 
-            if (this->data_.problemGraph.graph().findEdge(v, w).first) {
-                move_edges.emplace_back(std::make_pair(v, w));
-                move_edges.emplace_back(std::make_pair(w, v));
-            }
+        move_edges.clear();
+        for (const auto& vw : boundary) {
+            move_edges.emplace_back(vw.first, vw.second);
+            move_edges.emplace_back(vw.second, vw.first);
         }
-    }
+    };
+    findMoveEdges();
 
     if (move_edges.empty()) {
         return 0;
     }
 
     // mark nodes as available for swapping.
-    for (const auto& partition : { partitionA, partitionB }) {
-        for (const auto& v : partition) {
+    for (const auto partition : { &partitionA, &partitionB }) {
+        for (const auto& v : *partition) {
             swapped_[v] = false;
         }
     }
 
+    // rank the moves by their in-frame gain instead of proposing all of
+    // them in every iteration.
+    const size_t numberOfMoveCandidates = this->data_.numberOfMoveCandidates;
+    if (numberOfMoveCandidates > 0) {
+        initializeMoveGains(partitionIdA, partitionIdB, boundary);
+    }
+
     // start greedy search for improving moves
     localBranchingObjective_ =
         getBaselineBranchingObjective(partitionIdA, partitionIdB);
@@ -406,46 +688,52 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
 
         Move best;
 
-        // reset visits.
-        for (const auto& partition : { partitionA, partitionB }) {
-            for (const auto& v : partition) {
-                visited_[v] = false;
+        if (numberOfMoveCandidates > 0) {
+            best = proposeMoveByGain(partitionIdA, partitionIdB,
+                                     numberOfMoveCandidates);
+        } else {
+            // reset visits.
+            for (const auto partition : { &partitionA, &partitionB }) {
+                for (const auto& v : *partition) {
+                    visited_[v] = false;
+                }
             }
-        }
 
-        for (const auto& vw : move_edges) {
+            for (const auto& vw : move_edges) {
 
-            const auto v = vw.first;
-            const auto w = vw.second;
+                const auto v = vw.first;
+                const auto w = vw.second;
 
-            // /* Debug
-            if (partitionGraph_.vertexLabels_[v] ==
-                partitionGraph_.vertexLabels_[w]) {
-                std::cerr << v << "(" << partitionGraph_.vertexLabels_[v] << ")"
-                          << std::endl;
-                std::cerr << w << "(" << partitionGraph_.vertexLabels_[w] << ")"
-                          << std::endl;
-                throw std::runtime_error(
-                    "vertexLabels_ and partitions_ are inconsistent!");
-            }
-            // */
-
-            // prevent swapping back and forth
-            if (swapped_[v] || visited_[v]) {
-                continue;
-            }
-            visited_[v] = true;
+                // /* Debug
+                if (partitionGraph_.vertexLabels_[v] ==
+                    partitionGraph_.vertexLabels_[w]) {
+                    std::cerr << v << "(" << partitionGraph_.vertexLabels_[v]
+                              << ")" << std::endl;
+                    std::cerr << w << "(" << partitionGraph_.vertexLabels_[w]
+                              << ")" << std::endl;
+                    throw std::runtime_error(
+                        "vertexLabels_ and partitions_ are inconsistent!");
+                }
+                // */
 
-            // dont let partitions vanish.
-            // This case is handled by a complete merge.
-            if (partitionGraph_.partitions_[partitionGraph_.vertexLabels_[v]]
-                    .size() <= 1) {
-                continue;
-            }
+                // prevent swapping back and forth
+                if (swapped_[v] || visited_[v]) {
+                    continue;
+                }
+                visited_[v] = true;
+
+                // dont let partitions vanish.
+                // This case is handled by a complete merge.
+                if (partitionGraph_
+                        .partitions_[partitionGraph_.vertexLabels_[v]]
+                        .size() <= 1) {
+                    continue;
+                }
 
-            const auto move = proposeSingleMove(v, w);
-            if (lowerThanWithEpsilon(best.obj_, move.obj_)) {
-                best = move;
+                const auto move = proposeSingleMove(v, w);
+                if (lowerThanWithEpsilon(best.obj_, move.obj_)) {
+                    best = move;
+                }
             }
         }
 
@@ -461,6 +749,10 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
             swapped_[best.vertex_] = true;
             ++numberOfMoves;
 
+            if (numberOfMoveCandidates > 0) {
+                updateMoveGains(best.vertex_, partitionIdA, partitionIdB);
+            }
+
             // keep track of the best labeling.
             if (lowerThanWithEpsilon(bestObjective, getObjective())) {
 
@@ -470,8 +762,8 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
                 bestBranchingObjective = branchingObjective_;
 
                 // update best vertex labeling.
-                for (auto partition : { partitionA, partitionB }) {
-                    for (auto v : partition) {
+                for (const auto partition : { &partitionA, &partitionB }) {
+                    for (auto v : *partition) {
                         bestVertexLabels_[v] = partitionGraph_.vertexLabels_[v];
                     }
                 }
@@ -479,15 +771,10 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
         }
 
         // search new feasible moves.
-        move_edges.clear();
-        for (const auto& v : partitionA) {
-            for (const auto& w : partitionB) {
-
-                if (this->data_.problemGraph.graph().findEdge(v, w).first) {
-                    move_edges.emplace_back(std::make_pair(v, w));
-                    move_edges.emplace_back(std::make_pair(w, v));
-                }
-            }
+        if (numberOfMoveCandidates > 0) {
+            restoreMoveCandidates();
+        } else {
+            findMoveEdges();
         }
     }
 
@@ -501,8 +788,8 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
             bestNumberOfMoves = numberOfMoves;
 
             // update best vertex labeling.
-            for (auto partition : { partitionA, partitionB }) {
-                for (auto v : partition) {
+            for (const auto partition : { &partitionA, &partitionB }) {
+                for (auto v : *partition) {
                     bestVertexLabels_[v] = partitionGraph_.vertexLabels_[v];
                 }
             }
@@ -515,8 +802,8 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
         std::vector<size_t> buffer;
         buffer.reserve(partitionA.size() + partitionB.size());
 
-        for (auto partition : { partitionA, partitionB }) {
-            for (auto v : partition) {
+        for (const auto partition : { &partitionA, &partitionB }) {
+            for (auto v : *partition) {
                 if (bestVertexLabels_[v] != partitionGraph_.vertexLabels_[v]) {
                     buffer.push_back(v);
                 }
@@ -539,6 +826,10 @@ PartitionOptimizerBase<BROPT>::improveBipartition(size_t partitionIdA,
 
     // assert(std::abs(getObjective() - bestObjective) < EPSILON);
 
+#ifdef DEBUG
+    partitionGraph_.checkConsistency();
+#endif
+
     return bestNumberOfMoves;
 }
 
@@ -577,6 +868,156 @@ PartitionOptimizerBase<BROPT>::proposeSingleMove(const size_t vertex,
              branchingObjective_ + dLocalBranchingObj, getObjective() + dObj };
 }
 
+/// propose the moves of up to numberOfCandidates vertices of the highest
+/// in-frame gain and return the best one by the total objective.
+///   Cf. Fiduccia and Mattheyses (1982): The in-frame gains are kept in a
+///   heap and only updated for the neighbours of a moved vertex, whereas
+///   the branching is only solved for the proposed moves. Vertices are
+///   popped until one of the proposed moves is feasible.
+template <class BROPT>
+inline typename PartitionOptimizerBase<BROPT>::Move
+PartitionOptimizerBase<BROPT>::proposeMoveByGain(
+    const size_t partitionIdA, const size_t partitionIdB,
+    const size_t numberOfCandidates)
+{
+    const auto& graph = this->data_.problemGraph.graph();
+    const auto& labels = partitionGraph_.vertexLabels_;
+
+    Move best;
+    size_t numberOfProposals = 0;
+    while (!gainHeap_.empty() &&
+           (numberOfProposals < numberOfCandidates || std::isinf(best.obj_))) {
+        const auto v = gainHeap_.top().second;
+        gainHeap_.pop();
+        gainHandles_[v] = noHandle();
+
+        // find a neighbour in the other partition. Vertices without are
+        // dropped until one of their neighbours moves.
+        const auto other =
+            labels[v] == partitionIdA ? partitionIdB : partitionIdA;
+        auto w = v;
+        for (auto it = graph.adjacenciesInFrameBegin(v);
+             it != graph.adjacenciesInFrameEnd(v); ++it) {
+            if (labels[it->vertex()] == other) {
+                w = it->vertex();
+                break;
+            }
+        }
+        if (w == v) {
+            continue;
+        }
+        moveCandidates_.push_back(v);
+
+        // dont let partitions vanish.
+        // This case is handled by a complete merge.
+        if (partitionGraph_.partitions_[labels[v]].size() <= 1) {
+            continue;
+        }
+
+        const auto move = proposeSingleMove(v, w);
+        ++numberOfProposals;
+        if (lowerThanWithEpsilon(best.obj_, move.obj_)) {
+            best = move;
+        }
+    }
+
+    return best;
+}
+
+/// decrease of the internal objective by moving vertex to the other one of
+/// the partitions A and B.
+template <class BROPT>
+inline double
+PartitionOptimizerBase<BROPT>::inFrameGain(const size_t vertex,
+                                           const size_t partitionIdA,
+                                           const size_t partitionIdB) const
+{
+    const auto& graph = this->data_.problemGraph.graph();
+    const auto& labels = partitionGraph_.vertexLabels_;
+
+    const auto previous = labels[vertex];
+    const auto target = previous == partitionIdA ? partitionIdB : partitionIdA;
+
+    double gain = .0;
+    for (auto it = graph.adjacenciesInFrameBegin(vertex);
+         it != graph.adjacenciesInFrameEnd(vertex); ++it) {
+        if (labels[it->vertex()] == target) {
+            gain += this->data_.costs[it->edge()];
+        } else if (labels[it->vertex()] == previous) {
+            gain -= this->data_.costs[it->edge()];
+        }
+    }
+
+    return gain;
+}
+
+/// rank the vertices of the boundary between A and B by their gain.
+template <class BROPT>
+inline void
+PartitionOptimizerBase<BROPT>::initializeMoveGains(
+    const size_t partitionIdA, const size_t partitionIdB,
+    std::vector<std::pair<size_t, size_t>> const& boundary)
+{
+    gainHeap_.clear();
+    moveCandidates_.clear();
+
+    // nodes are only pushed while their partition is improved.
+    for (const auto partitionId : { partitionIdA, partitionIdB }) {
+        for (const auto v : partitionGraph_.partitions_[partitionId]) {
+            gainHandles_[v] = noHandle();
+        }
+    }
+
+    for (const auto& vw : boundary) {
+        for (const auto v : { vw.first, vw.second }) {
+            if (gainHandles_[v] == noHandle()) {
+                moveGains_[v] = inFrameGain(v, partitionIdA, partitionIdB);
+                gainHandles_[v] = gainHeap_.push({ moveGains_[v], v });
+            }
+        }
+    }
+}
+
+/// update the gains of the neighbours of a moved vertex.
+template <class BROPT>
+inline void
+PartitionOptimizerBase<BROPT>::updateMoveGains(const size_t vertex,
+                                               const size_t partitionIdA,
+                                               const size_t partitionIdB)
+{
+    const auto& graph = this->data_.problemGraph.graph();
+    const auto& labels = partitionGraph_.vertexLabels_;
+
+    for (auto it = graph.adjacenciesInFrameBegin(vertex);
+         it != graph.adjacenciesInFrameEnd(vertex); ++it) {
+        const auto u = it->vertex();
+        if (swapped_[u] ||
+            (labels[u] != partitionIdA && labels[u] != partitionIdB)) {
+            continue;
+        }
+
+        moveGains_[u] = inFrameGain(u, partitionIdA, partitionIdB);
+        if (gainHandles_[u] == noHandle()) {
+            gainHandles_[u] = gainHeap_.push({ moveGains_[u], u });
+        } else {
+            gainHeap_.update(gainHandles_[u], { moveGains_[u], u });
+        }
+    }
+}
+
+/// push the vertices popped by proposeMoveByGain again.
+template <class BROPT>
+inline void
+PartitionOptimizerBase<BROPT>::restoreMoveCandidates()
+{
+    for (const auto v : moveCandidates_) {
+        if (!swapped_[v] && gainHandles_[v] == noHandle()) {
+            gainHandles_[v] = gainHeap_.push({ moveGains_[v], v });
+        }
+    }
+    moveCandidates_.clear();
+}
+
 /// move the vertex.
 ///
 template <class BROPT>
@@ -603,16 +1044,8 @@ PartitionOptimizerBase<BROPT>::applyMerge(size_t partitionIdA,
     }
 
     // calculate gain (in-frame) of merging.
-    Cost dObj = .0;
-    for (const auto& v : partitionA) {
-        for (const auto& w : partitionB) {
-            const auto p = this->data_.problemGraph.graph().findEdge(v, w);
-            if (p.first) {
-                dObj -= this->data_.costs[p.second];
-            }
-        }
-    }
-    internalObjective_ += dObj;
+    internalObjective_ -=
+        partitionGraph_.boundaryCost(partitionIdA, partitionIdB);
 
     // merge & update partitionGraph
     size_t otherId;
@@ -758,8 +1191,8 @@ PartitionOptimizerBase<BROPT>::splitPartition(size_t partitionId)
             bestBranchingObjective = branchingObjective_;
 
             // update best vertex labeling.
-            for (const auto& partition : { partitionA, partitionB }) {
-                for (const auto& v : partition) {
+            for (const auto partition : { &partitionA, &partitionB }) {
+                for (const auto& v : *partition) {
                     bestVertexLabels_[v] = partitionGraph_.vertexLabels_[v];
                 }
             }
@@ -791,8 +1224,8 @@ PartitionOptimizerBase<BROPT>::splitPartition(size_t partitionId)
         std::vector<size_t> buffer;
         buffer.reserve(partitionA.size() + partitionB.size());
 
-        for (const auto& partition : { partitionA, partitionB }) {
-            for (const auto& v : partition) {
+        for (const auto partition : { &partitionA, &partitionB }) {
+            for (const auto& v : *partition) {
                 if (bestVertexLabels_[v] != partitionGraph_.vertexLabels_[v]) {
                     buffer.push_back(v);
                 }
@@ -831,6 +1264,12 @@ class LocalPartitionOptimizer : public PartitionOptimizerBase<BROPT>
 private:
     using LocalBranchingOptimizer = LBROPT;
 
+    std::unique_ptr<PartitionOptimizerBase<BROPT>> create(
+        Data& data, Solution const& solution) const override
+    {
+        return std::unique_ptr<PartitionOptimizerBase<BROPT>>(
+            new LocalPartitionOptimizer(data, solution));
+    }
     double solveLocalBranchingProblem(size_t partitionIdA,
                                       size_t partitionIdB) const override;
     double getBaselineBranchingObjective(size_t partitionIdA,
@@ -857,6 +1296,54 @@ LocalPartitionOptimizer<BROPT, LBROPT>::getBaselineBranchingObjective(
     return solveLocalBranchingProblem(partitionIdA, partitionIdB);
 }
 
+/// KLB implementation that keeps the optimal branching of all partitions
+/// in the partition graph and repairs it after each move, such that the
+/// cost of evaluating a move scales with the partitions it changes.
+/// The gain/loss in the branching is exact (global), unlike the local
+/// branching problems of LocalPartitionOptimizer.
+///
+template <class BROPT>
+class IncrementalPartitionOptimizer : public PartitionOptimizerBase<BROPT>
+{
+public:
+    IncrementalPartitionOptimizer(Data& data, Solution initialSolution)
+      : PartitionOptimizerBase<BROPT>(data, initialSolution)
+    {
+        this->partitionGraph_.enableIncrementalBranching();
+    }
+
+private:
+    std::unique_ptr<PartitionOptimizerBase<BROPT>> create(
+        Data& data, Solution const& solution) const override
+    {
+        return std::unique_ptr<PartitionOptimizerBase<BROPT>>(
+            new IncrementalPartitionOptimizer(data, solution));
+    }
+    double solveLocalBranchingProblem(size_t partitionIdA,
+                                      size_t partitionIdB) const override;
+    double getBaselineBranchingObjective(size_t partitionIdA,
+                                         size_t partitionIdB) const override;
+    std::string getMethodName() const override { return "KLBincremental"; };
+};
+
+/// Arguments are discarded, the branching is repaired where the partition
+/// graph changed.
+template <class BROPT>
+inline double
+IncrementalPartitionOptimizer<BROPT>::solveLocalBranchingProblem(
+    size_t partitionIdA, size_t partitionIdB) const
+{
+    return this->partitionGraph_.incrementalBranchingObjective();
+}
+
+template <class BROPT>
+inline double
+IncrementalPartitionOptimizer<BROPT>::getBaselineBranchingObjective(
+    size_t partitionIdA, size_t partitionIdB) const
+{
+    return this->partitionGraph_.incrementalBranchingObjective();
+}
+
 /// KLB implementation that always solves the *full* branching problem.
 /// This is inefficient and advised for comparison purposes only.
 ///
@@ -867,6 +1354,12 @@ public:
     using PartitionOptimizerBase<BROPT>::PartitionOptimizerBase;
 
 private:
+    std::unique_ptr<PartitionOptimizerBase<BROPT>> create(
+        Data& data, Solution const& solution) const override
+    {
+        return std::unique_ptr<PartitionOptimizerBase<BROPT>>(
+            new FullPartitionOptimizer(data, solution));
+    }
     double solveLocalBranchingProblem(size_t partitionIdA,
                                       size_t partitionIdB) const override;
     double getBaselineBranchingObjective(size_t partitionIdA,
@@ -0,0 +1,279 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_SPARSE_ASSIGNMENT_HXX
+#define LINEAGE_HEURISTICS_SPARSE_ASSIGNMENT_HXX
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lineage {
+namespace heuristics {
+
+/// Minimum-cost assignment of all rows to distinct columns on a sparse
+/// bipartite graph.
+///
+/// Edges are stored in compressed sparse rows. Each unassigned row is
+/// assigned along a shortest augmenting path, found by Dijkstra's algorithm
+/// on the reduced costs c(i, j) - u(i) - v(j) as in the augmentation phase
+/// of Jonker and Volgenant (1987). Any column potentials v are feasible at
+/// the start, so the potentials of a previous solve() of a similar problem
+/// can be passed to setColumnPotentials() to shorten the augmenting paths.
+class SparseAssignment
+{
+public:
+    static constexpr size_t none()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    /// start a new problem without edges. Column potentials set before are
+    /// kept if the number of columns matches.
+    void reset(const size_t numberOfRows, const size_t numberOfColumns)
+    {
+        numberOfRows_ = numberOfRows;
+        numberOfColumns_ = numberOfColumns;
+        rows_.clear();
+        columns_.clear();
+        costs_.clear();
+
+        if (v_.size() != numberOfColumns_)
+            v_.assign(numberOfColumns_, .0);
+    }
+
+    /// returns the index of the edge, counting from 0 in the order added.
+    size_t addEdge(const size_t row, const size_t column, const double cost)
+    {
+        if (row >= numberOfRows_ || column >= numberOfColumns_)
+            throw std::out_of_range("edge of assignment out of range.");
+
+        rows_.push_back(row);
+        columns_.push_back(column);
+        costs_.push_back(cost);
+        return rows_.size() - 1;
+    }
+
+    size_t numberOfRows() const { return numberOfRows_; }
+    size_t numberOfColumns() const { return numberOfColumns_; }
+    size_t numberOfEdges() const { return rows_.size(); }
+
+    size_t rowOfEdge(const size_t edge) const { return rows_[edge]; }
+    size_t columnOfEdge(const size_t edge) const { return columns_[edge]; }
+    double costOfEdge(const size_t edge) const { return costs_[edge]; }
+
+    /// assign every row and return the total cost. Throws if no assignment
+    /// of all rows exists.
+    double solve()
+    {
+        buildRows();
+
+        rowOfColumn_.assign(numberOfColumns_, none());
+        arcOfRow_.assign(numberOfRows_, none());
+        u_.resize(numberOfRows_);
+        distance_.assign(numberOfColumns_, infinity());
+        predecessor_.resize(numberOfColumns_);
+        scanned_.assign(numberOfColumns_, false);
+
+        // row minima. A row whose best column is free takes it right away.
+        for (size_t row = 0; row < numberOfRows_; ++row) {
+            size_t best = none();
+            for (auto a = rowBegin_[row]; a < rowBegin_[row + 1]; ++a)
+                if (best == none() || reducedCost(a) < reducedCost(best))
+                    best = a;
+
+            if (best == none())
+                throw std::runtime_error("row of assignment has no edges.");
+
+            u_[row] = arcCosts_[best] - v_[arcColumns_[best]];
+            if (rowOfColumn_[arcColumns_[best]] == none()) {
+                rowOfColumn_[arcColumns_[best]] = row;
+                arcOfRow_[row] = best;
+            }
+        }
+
+        for (size_t row = 0; row < numberOfRows_; ++row)
+            if (arcOfRow_[row] == none())
+                augment(row);
+
+        double objective = .0;
+        for (size_t row = 0; row < numberOfRows_; ++row)
+            objective += arcCosts_[arcOfRow_[row]];
+
+        return objective;
+    }
+
+    /// edge assigned to row by the last solve().
+    size_t edgeOfRow(const size_t row) const
+    {
+        return arcEdges_[arcOfRow_[row]];
+    }
+
+    size_t columnOfRow(const size_t row) const
+    {
+        return arcColumns_[arcOfRow_[row]];
+    }
+
+    std::vector<double> const& columnPotentials() const { return v_; }
+
+    void setColumnPotentials(std::vector<double> potentials)
+    {
+        if (potentials.size() != numberOfColumns_)
+            throw std::runtime_error("wrong number of column potentials.");
+        v_ = std::move(potentials);
+    }
+
+private:
+    using Entry = std::pair<double, size_t>; // distance, column
+
+    static constexpr double infinity()
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double reducedCost(const size_t arc) const
+    {
+        return arcCosts_[arc] - v_[arcColumns_[arc]];
+    }
+
+    // sort the edges by row (counting sort, stable).
+    void buildRows()
+    {
+        rowBegin_.assign(numberOfRows_ + 1, 0);
+        for (auto row : rows_)
+            ++rowBegin_[row + 1];
+        for (size_t row = 0; row < numberOfRows_; ++row)
+            rowBegin_[row + 1] += rowBegin_[row];
+
+        arcColumns_.resize(rows_.size());
+        arcCosts_.resize(rows_.size());
+        arcEdges_.resize(rows_.size());
+        arcRows_.resize(rows_.size());
+
+        position_.assign(rowBegin_.begin(), rowBegin_.end() - 1);
+        for (size_t edge = 0; edge < rows_.size(); ++edge) {
+            const auto a = position_[rows_[edge]]++;
+            arcColumns_[a] = columns_[edge];
+            arcCosts_[a] = costs_[edge];
+            arcEdges_[a] = edge;
+            arcRows_[a] = rows_[edge];
+        }
+    }
+
+    // assign the free row source along a shortest augmenting path.
+    void augment(const size_t source)
+    {
+        const std::greater<Entry> compare;
+
+        heap_.clear();
+        touched_.clear();
+        path_.clear();
+
+        auto scanRow = [&](const size_t row, const double base) {
+            for (auto a = rowBegin_[row]; a < rowBegin_[row + 1]; ++a) {
+                const auto column = arcColumns_[a];
+                const auto d = base + arcCosts_[a] - u_[row] - v_[column];
+
+                if (d < distance_[column] && !scanned_[column]) {
+                    if (distance_[column] == infinity())
+                        touched_.push_back(column);
+                    distance_[column] = d;
+                    predecessor_[column] = a;
+                    heap_.emplace_back(d, column);
+                    std::push_heap(heap_.begin(), heap_.end(), compare);
+                }
+            }
+        };
+
+        scanRow(source, .0);
+
+        size_t sink = none();
+        double length = .0;
+        while (sink == none()) {
+            if (heap_.empty())
+                throw std::runtime_error("assignment is infeasible.");
+
+            std::pop_heap(heap_.begin(), heap_.end(), compare);
+            const auto entry = heap_.back();
+            heap_.pop_back();
+
+            const auto column = entry.second;
+            if (entry.first > distance_[column] || scanned_[column])
+                continue;
+
+            path_.push_back(column);
+            scanned_[column] = true;
+
+            if (rowOfColumn_[column] == none()) {
+                sink = column;
+                length = entry.first;
+            } else {
+                scanRow(rowOfColumn_[column], entry.first);
+            }
+        }
+
+        // update potentials such that the reduced costs remain non-negative
+        // and vanish along the path.
+        for (auto column : path_) {
+            const auto slack = length - distance_[column];
+            v_[column] -= slack;
+            if (rowOfColumn_[column] != none())
+                u_[rowOfColumn_[column]] += slack;
+        }
+        u_[source] += length;
+
+        // flip the path.
+        for (auto column = sink;;) {
+            const auto a = predecessor_[column];
+            const auto row = arcRows_[a];
+            const auto previous = arcOfRow_[row];
+
+            arcOfRow_[row] = a;
+            rowOfColumn_[column] = row;
+
+            if (row == source)
+                break;
+            column = arcColumns_[previous];
+        }
+
+        for (auto column : touched_) {
+            distance_[column] = infinity();
+            scanned_[column] = false;
+        }
+    }
+
+    size_t numberOfRows_{ 0 };
+    size_t numberOfColumns_{ 0 };
+
+    // edges in the order added.
+    std::vector<size_t> rows_;
+    std::vector<size_t> columns_;
+    std::vector<double> costs_;
+
+    // edges sorted by row (arcs).
+    std::vector<size_t> rowBegin_;
+    std::vector<size_t> arcColumns_;
+    std::vector<double> arcCosts_;
+    std::vector<size_t> arcEdges_;
+    std::vector<size_t> arcRows_;
+    std::vector<size_t> position_;
+
+    std::vector<double> u_; // row potentials
+    std::vector<double> v_; // column potentials
+    std::vector<size_t> rowOfColumn_;
+    std::vector<size_t> arcOfRow_;
+
+    // shortest path search.
+    std::vector<double> distance_;
+    std::vector<size_t> predecessor_; // arc, by column
+    std::vector<Entry> heap_;
+    std::vector<bool> scanned_;
+    std::vector<size_t> touched_; // columns with finite distance
+    std::vector<size_t> path_;    // scanned columns, in order
+};
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -0,0 +1,317 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_STREAMING_LINEAGE_HXX
+#define LINEAGE_HEURISTICS_STREAMING_LINEAGE_HXX
+
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "greedy-lineage.hxx"
+#include "lineage/problem-graph.hxx"
+#include "lineage/problem.hxx"
+
+namespace lineage {
+namespace heuristics {
+
+/// Greedy lineage agglomeration over a stream of frames.
+///
+/// Frames are added one at a time. As soon as windowSize frames are pending,
+/// they are optimized jointly by GLA and the oldest of them is committed:
+/// its fragments (clusters of nodes) and their parents become final, its
+/// labels are passed to the callback and its nodes are evicted. The last
+/// committed frame enters the next window as frame 0 with one node per
+/// fragment, such that past decisions are kept while the termination of
+/// its fragments is still priced. Memory is therefore bounded by the size
+/// of the window instead of the length of the sequence.
+class StreamingLineage
+{
+public:
+    struct Settings
+    {
+        size_t windowSize{ 5 }; // number of frames optimized jointly, >= 2.
+        double costTermination{ .0 };
+        double costBirth{ .0 };
+        bool enforceBifurcationConstraint{ false };
+    };
+
+    /// final labels of one frame.
+    struct CommittedFrame
+    {
+        int t;
+        std::vector<int> ids;          // of the nodes, in the order added.
+        std::vector<size_t> fragments; // of the nodes, within the frame.
+        std::vector<size_t> cells;     // of the nodes, over the sequence.
+
+        // (mother, daughter) for all cells that begin in this frame as one
+        // of several descendants of a cell in the previous frame.
+        std::vector<std::pair<size_t, size_t>> cellEdges;
+    };
+
+    using Callback = std::function<void(CommittedFrame const&)>;
+
+    StreamingLineage(Settings const& settings, Callback callback)
+      : settings_(settings)
+      , callback_(std::move(callback))
+    {
+        // with a single frame, each window would commit its last frame, in
+        // which termination is free, such that costTermination is ignored.
+        if (settings_.windowSize < 2)
+            throw std::runtime_error("window size must be at least 2.");
+    }
+
+    /// add the next frame: its nodes and all edges within it or from the
+    /// previous frame. As in Problem, v0 and v1 of an edge index the nodes
+    /// of frame t0 and t1 in the order they were added.
+    void addFrame(std::vector<Node> nodes, std::vector<Edge> edges)
+    {
+        const int t = nextFrame_++;
+
+        for (auto const& node : nodes)
+            if (node.t != t)
+                throw std::runtime_error("node is not in the added frame.");
+
+        for (auto& edge : edges) {
+            if (edge.t0 > edge.t1) {
+                std::swap(edge.t0, edge.t1);
+                std::swap(edge.v0, edge.v1);
+            }
+
+            if (edge.t1 != t || (edge.t0 != t && edge.t0 + 1 != t) ||
+                edge.t0 < 0)
+                throw std::runtime_error("edge is not in the added frame.");
+        }
+
+        pending_.push_back({ t, std::move(nodes), std::move(edges) });
+
+        if (pending_.size() == settings_.windowSize)
+            optimizeAndCommit(1);
+    }
+
+    /// commit all pending frames.
+    void finish()
+    {
+        if (!pending_.empty())
+            optimizeAndCommit(pending_.size());
+    }
+
+    size_t numberOfCells() const { return numberOfCells_; }
+
+private:
+    struct Frame
+    {
+        int t;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+    };
+
+    // the last committed frame.
+    struct Anchor
+    {
+        std::vector<size_t> fragmentOfNode;
+        std::vector<size_t> sizes; // of the fragments
+        std::vector<size_t> cells; // of the fragments
+    };
+
+    class Agglomeration : public GreedyLineageAgglomeration<>
+    {
+    public:
+        Agglomeration(Data& data)
+          : GreedyLineageAgglomeration<>(data)
+        {
+        }
+
+        // number of nodes that vertex v stands for.
+        void setSize(const size_t v, const size_t size)
+        {
+            this->sizes_[v] = size;
+        }
+    };
+
+    void optimizeAndCommit(const size_t numberOfFrames)
+    {
+        const size_t offset = hasAnchor_ ? 1 : 0;
+        const auto window = buildWindow(offset);
+
+        std::unique_ptr<ProblemGraph> problemGraph;
+        std::unique_ptr<Data> data;
+        std::unique_ptr<Agglomeration> agglomeration;
+
+        if (!window.nodes.empty()) {
+            problemGraph.reset(new ProblemGraph(window));
+            data.reset(new Data(*problemGraph));
+
+            OptimizationLog::Settings logSettings;
+            logSettings.enabled = false;
+            data->log.configure(logSettings);
+
+            data->costTermination = settings_.costTermination;
+            data->costBirth = settings_.costBirth;
+            data->enforceBifurcationConstraint =
+                settings_.enforceBifurcationConstraint;
+            data->incrementalReproposal = true;
+            data->maxDistance = std::numeric_limits<size_t>::max();
+
+            for (auto const& e : window.edges)
+                data->costs.push_back(e.weight);
+
+            if (settings_.costTermination > 0.0)
+                data->costs.insert(data->costs.end(), window.nodes.size(),
+                                   settings_.costTermination);
+
+            if (settings_.costBirth > 0.0)
+                data->costs.insert(data->costs.end(), window.nodes.size(),
+                                   settings_.costBirth);
+
+            agglomeration.reset(new Agglomeration(*data));
+            for (size_t f = 0; f < anchor_.sizes.size(); ++f)
+                agglomeration->setSize(f, anchor_.sizes[f]);
+
+            agglomeration->setSilent(true);
+            agglomeration->optimize();
+        }
+
+        // fragment of each representative of a committed frame. Vertices
+        // of the anchor are never merged, so they represent themselves.
+        const auto none = std::numeric_limits<size_t>::max();
+        std::vector<size_t> fragmentOfRep(window.nodes.size(), none);
+        for (size_t f = 0; f < anchor_.sizes.size(); ++f)
+            fragmentOfRep[f] = f;
+
+        auto previousCells = anchor_.cells;
+
+        size_t firstVertex = anchor_.sizes.size();
+        for (size_t i = 0; i < numberOfFrames; ++i) {
+            auto& frame = pending_[i];
+
+            CommittedFrame committed;
+            committed.t = frame.t;
+
+            Anchor next;
+            std::vector<size_t> parents; // of the fragments
+
+            for (size_t j = 0; j < frame.nodes.size(); ++j) {
+                const auto v = firstVertex + j;
+                const auto rep = agglomeration->findRep(v);
+
+                if (fragmentOfRep[rep] == none) {
+                    fragmentOfRep[rep] = next.sizes.size();
+                    next.sizes.push_back(0);
+
+                    const auto parent = agglomeration->hasParent(v);
+                    parents.push_back(parent.first ? fragmentOfRep[parent.second]
+                                                   : none);
+                }
+
+                next.fragmentOfNode.push_back(fragmentOfRep[rep]);
+                ++next.sizes[fragmentOfRep[rep]];
+            }
+
+            // a fragment continues the cell of its parent iff it is its
+            // only descendant, as in SolutionGraph.
+            std::vector<size_t> numberOfChildren(previousCells.size(), 0);
+            for (auto p : parents)
+                if (p != none)
+                    ++numberOfChildren[p];
+
+            for (auto p : parents) {
+                if (p != none && numberOfChildren[p] == 1) {
+                    next.cells.push_back(previousCells[p]);
+                } else {
+                    next.cells.push_back(numberOfCells_++);
+
+                    if (p != none)
+                        committed.cellEdges.emplace_back(previousCells[p],
+                                                         next.cells.back());
+                }
+            }
+
+            for (size_t j = 0; j < frame.nodes.size(); ++j) {
+                committed.ids.push_back(frame.nodes[j].id);
+                committed.fragments.push_back(next.fragmentOfNode[j]);
+                committed.cells.push_back(next.cells[next.fragmentOfNode[j]]);
+            }
+
+            callback_(committed);
+
+            firstVertex += frame.nodes.size();
+            previousCells = next.cells;
+            anchor_ = std::move(next);
+            hasAnchor_ = true;
+        }
+
+        pending_.erase(pending_.begin(), pending_.begin() + numberOfFrames);
+    }
+
+    // problem of the pending frames, preceded by the anchor if any.
+    Problem buildWindow(const size_t offset) const
+    {
+        Problem window;
+
+        for (size_t f = 0; f < anchor_.sizes.size(); ++f)
+            window.nodes.push_back({ 0, static_cast<int>(f), 0, 0, .0 });
+
+        for (size_t i = 0; i < pending_.size(); ++i)
+            for (auto node : pending_[i].nodes) {
+                node.t = static_cast<int>(i + offset);
+                window.nodes.push_back(node);
+            }
+
+        auto checkNode = [](int v, size_t numberOfNodes) {
+            if (v < 0 || static_cast<size_t>(v) >= numberOfNodes)
+                throw std::runtime_error("edge refers to a missing node.");
+        };
+
+        // edges from the anchor are summed per fragment.
+        std::map<std::pair<size_t, int>, double> anchorEdges;
+
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            const int t = static_cast<int>(i + offset);
+
+            for (auto const& edge : pending_[i].edges) {
+                checkNode(edge.v1, pending_[i].nodes.size());
+
+                if (edge.t0 == edge.t1) {
+                    checkNode(edge.v0, pending_[i].nodes.size());
+                    window.edges.push_back(
+                        { t, edge.v0, t, edge.v1, edge.weight });
+                } else if (i > 0) {
+                    checkNode(edge.v0, pending_[i - 1].nodes.size());
+                    window.edges.push_back(
+                        { t - 1, edge.v0, t, edge.v1, edge.weight });
+                } else if (hasAnchor_) {
+                    checkNode(edge.v0, anchor_.fragmentOfNode.size());
+                    anchorEdges[{ anchor_.fragmentOfNode[edge.v0], edge.v1 }] +=
+                        edge.weight;
+                } else {
+                    throw std::runtime_error(
+                        "edge refers to a frame before the first.");
+                }
+            }
+        }
+
+        for (auto const& e : anchorEdges)
+            window.edges.push_back({ 0, static_cast<int>(e.first.first), 1,
+                                     e.first.second, e.second });
+
+        return window;
+    }
+
+    Settings settings_;
+    Callback callback_;
+
+    std::deque<Frame> pending_;
+    Anchor anchor_;
+    bool hasAnchor_{ false };
+    int nextFrame_{ 0 };
+    size_t numberOfCells_{ 0 };
+};
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
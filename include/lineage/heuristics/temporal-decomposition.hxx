@@ -0,0 +1,251 @@
+#pragma once
+#ifndef LINEAGE_HEURISTICS_TEMPORAL_DECOMPOSITION_HXX
+#define LINEAGE_HEURISTICS_TEMPORAL_DECOMPOSITION_HXX
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "heuristic-base.hxx"
+#include "lineage/problem-graph.hxx"
+#include "lineage/solution.hxx"
+
+namespace lineage {
+namespace heuristics {
+
+struct DecompositionSettings
+{
+    size_t numberOfBlocks{ 0 }; // 0: one block per thread of the pool.
+    size_t overlap{ 3 };        // frames added on both sides of a block.
+};
+
+namespace detail {
+
+/// consecutive frames [first, last) of a problem, of which [coreFirst,
+/// coreLast) are owned by the block.
+struct TemporalBlock
+{
+    size_t first;
+    size_t last;
+    size_t coreFirst;
+    size_t coreLast;
+
+    Problem problem;           // frames relabeled to start at 0.
+    std::vector<size_t> edges; // in the original problem, by edge of block.
+    Solution solution;
+};
+
+inline void
+extractBlock(ProblemGraph const& problemGraph, TemporalBlock& block)
+{
+    auto const& problem = problemGraph.problem();
+    const int offset = static_cast<int>(block.first);
+
+    // nodes are added frame by frame in their original order, such that
+    // the v0 and v1 of the edges remain valid.
+    for (size_t t = block.first; t < block.last; ++t)
+        for (size_t j = 0; j < problemGraph.numberOfNodesInFrame(t); ++j) {
+            auto node = problem.nodes[problemGraph.nodeInFrame(t, j)];
+            node.t -= offset;
+            block.problem.nodes.push_back(node);
+        }
+
+    auto addEdge = [&](const size_t e) {
+        auto edge = problem.edges[e];
+        edge.t0 -= offset;
+        edge.t1 -= offset;
+        block.problem.edges.push_back(edge);
+        block.edges.push_back(e);
+    };
+
+    for (size_t t = block.first; t < block.last; ++t) {
+        if (t > block.first)
+            for (size_t j = 0; j < problemGraph.numberOfEdgesFromFrame(t - 1);
+                 ++j)
+                addEdge(problemGraph.edgeFromFrame(t - 1, j));
+
+        for (size_t j = 0; j < problemGraph.numberOfEdgesInFrame(t); ++j)
+            addEdge(problemGraph.edgeInFrame(t, j));
+    }
+}
+
+template <class OPTIMIZER, class INITIALIZER>
+void
+solveBlock(TemporalBlock& block, double costTermination, double costBirth,
+           bool enforceBifurcationConstraint, size_t maxDistance,
+           PartitionOptimizerSettings partitionSettings,
+           std::shared_ptr<ThreadPool> threadPool)
+{
+    if (block.problem.nodes.empty())
+        return;
+
+    ProblemGraph problemGraph(block.problem);
+    Data data(problemGraph);
+
+    OptimizationLog::Settings logSettings;
+    logSettings.enabled = false;
+    data.log.configure(logSettings);
+
+    data.costBirth = costBirth;
+    data.costTermination = costTermination;
+    data.enforceBifurcationConstraint = enforceBifurcationConstraint;
+    data.maxDistance = maxDistance;
+    data.incrementalReproposal = true;
+    data.numberOfMoveCandidates = partitionSettings.numberOfMoveCandidates;
+    data.threadPool = threadPool;
+
+    for (auto const& e : block.problem.edges)
+        data.costs.push_back(e.weight);
+
+    if (costTermination > 0.0)
+        data.costs.insert(data.costs.end(), block.problem.nodes.size(),
+                          costTermination);
+
+    if (costBirth > 0.0)
+        data.costs.insert(data.costs.end(), block.problem.nodes.size(),
+                          costBirth);
+
+    Solution init;
+    {
+        auto initializer = INITIALIZER(data);
+        initializer.setSilent(true);
+        initializer.optimize();
+        init = initializer.getSolution();
+    }
+
+    auto search = OPTIMIZER(data, init);
+    search.setSilent(true);
+    search.optimize();
+    block.solution = search.getSolution();
+}
+
+} // namespace detail
+
+/// Solve a problem block by block in time.
+///
+/// The frames are split into numberOfBlocks consecutive blocks, each of
+/// which is extended by overlap frames on both sides and solved by
+/// INITIALIZER and OPTIMIZER as a task of the thread pool. The in-frame labels of
+/// each frame are taken from the block that owns the frame, which fixes the
+/// partitions of the whole problem. In a boundary-fixing pass, OPTIMIZER
+/// then recomputes the branching of these partitions globally and starts
+/// its moves from the frames within overlap of a block border. As the blocks
+/// already run in parallel, partitionSettings.parallelBipartitions only
+/// applies to the boundary-fixing pass.
+template <class OPTIMIZER, class INITIALIZER>
+Solution
+applyDecomposedHeuristic(
+    ProblemGraph const& problemGraph, double costTermination = .0,
+    double costBirth = .0, bool enforceBifurcationConstraint = false,
+    std::string solutionName = "heuristic",
+    size_t maxDistance = std::numeric_limits<size_t>::max(),
+    OptimizationLog::Settings logSettings = {},
+    DecompositionSettings settings = {},
+    PartitionOptimizerSettings partitionSettings = {})
+{
+    Data data(problemGraph);
+
+    // create log file/replace existing log file with empty log file
+    data.log.configure(logSettings);
+    openOptimizationLog(data.log, solutionName);
+
+    data.costBirth = costBirth;
+    data.costTermination = costTermination;
+    data.enforceBifurcationConstraint = enforceBifurcationConstraint;
+    data.solutionName = solutionName;
+    data.maxDistance = maxDistance;
+    data.parallelBipartitions = partitionSettings.parallelBipartitions;
+    data.numberOfMoveCandidates = partitionSettings.numberOfMoveCandidates;
+
+    // define costs
+    for (auto e : problemGraph.problem().edges)
+        data.costs.push_back(e.weight);
+
+    if (costTermination > 0.0)
+        data.costs.insert(data.costs.end(),
+                          problemGraph.graph().numberOfVertices(),
+                          costTermination);
+
+    if (costBirth > 0.0)
+        data.costs.insert(data.costs.end(),
+                          problemGraph.graph().numberOfVertices(), costBirth);
+
+    const size_t numberOfFrames = problemGraph.numberOfFrames();
+    const size_t numberOfBlocks = std::max<size_t>(
+        1, std::min(numberOfFrames,
+                    settings.numberOfBlocks > 0
+                        ? settings.numberOfBlocks
+                        : data.threadPool->numberOfThreads()));
+
+    data.timer.start();
+
+    std::vector<detail::TemporalBlock> blocks(numberOfBlocks);
+    for (size_t i = 0; i < numberOfBlocks; ++i) {
+        auto& block = blocks[i];
+        block.coreFirst = i * numberOfFrames / numberOfBlocks;
+        block.coreLast = (i + 1) * numberOfFrames / numberOfBlocks;
+        block.first = block.coreFirst - std::min(block.coreFirst,
+                                                 settings.overlap);
+        block.last =
+            std::min(numberOfFrames, block.coreLast + settings.overlap);
+    }
+
+    data.threadPool->parallelFor(numberOfBlocks, [&](size_t i) {
+        detail::extractBlock(problemGraph, blocks[i]);
+        detail::solveBlock<OPTIMIZER, INITIALIZER>(
+            blocks[i], costTermination, costBirth,
+            enforceBifurcationConstraint, maxDistance, partitionSettings,
+            data.threadPool);
+    });
+
+    data.timer.stop();
+    std::cout << "[Decomposition] Solved " << numberOfBlocks
+              << " blocks in " << data.timer.get_elapsed_seconds() << "s."
+              << std::endl;
+    data.timer.start();
+
+    // stitch in-frame labels. Labels of edges between frames only serve as
+    // initialization, as the branching is recomputed below.
+    Solution stitched;
+    stitched.edge_labels.assign(problemGraph.problem().edges.size(), 1);
+
+    for (auto const& block : blocks)
+        for (size_t j = 0; j < block.edges.size(); ++j) {
+            const auto& edge = block.problem.edges[j];
+            const auto t = block.first + edge.t1;
+
+            if (t >= block.coreFirst && t < block.coreLast)
+                stitched.edge_labels[block.edges[j]] =
+                    block.solution.edge_labels[j];
+        }
+
+    // frames next to a border between blocks.
+    std::vector<bool> borderFrames(numberOfFrames, false);
+    for (size_t i = 1; i < numberOfBlocks; ++i) {
+        const auto border = blocks[i].coreFirst;
+        const auto width = std::max<size_t>(1, settings.overlap);
+
+        for (size_t t = border - std::min(border, width);
+             t < std::min(numberOfFrames, border + width); ++t)
+            borderFrames[t] = true;
+    }
+
+    auto search = OPTIMIZER(data, stitched);
+    search.setInitialFrames(borderFrames);
+
+    search.optimize();
+    const auto solution = search.getSolution();
+    data.timer.stop();
+
+    postOptimizationChecks(data, search, solution);
+
+    return solution;
+}
+
+} // namespace heuristics
+} // namespace lineage
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef LINEAGE_OPTIMIZATION_LOG_HXX
+#define LINEAGE_OPTIMIZATION_LOG_HXX
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace lineage {
+
+/// Buffered sink for <solution>-optimization-log.txt.
+///
+/// Records are collected in memory and written to the file when the buffer
+/// exceeds flushSize bytes, when flushInterval seconds have passed since the
+/// last write, on flush() and on destruction. A disabled log discards all
+/// records and never touches the file system.
+class OptimizationLog
+{
+public:
+    struct Settings
+    {
+        bool enabled{ true };
+        double flushInterval{ 1.0 }; // seconds
+        size_t flushSize{ 1 << 16 }; // bytes
+    };
+
+    OptimizationLog() = default;
+    OptimizationLog(OptimizationLog const&) = delete;
+    OptimizationLog& operator=(OptimizationLog const&) = delete;
+
+    ~OptimizationLog()
+    {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    void configure(Settings const& settings) { settings_ = settings; }
+
+    Settings const& settings() const { return settings_; }
+
+    bool enabled() const { return settings_.enabled; }
+
+    /// (re-)create the log file, discarding previous content and all
+    /// records that have not been written yet.
+    void open(std::string const& fileName)
+    {
+        buffer_.clear();
+
+        if (file_.is_open())
+            file_.close();
+
+        if (!enabled())
+            return;
+
+        file_.open(fileName, std::ofstream::out | std::ofstream::trunc);
+        if (!file_)
+            throw std::runtime_error("could not open " + fileName + ".");
+
+        lastFlush_ = Clock::now();
+    }
+
+    void append(std::string const& record)
+    {
+        if (!enabled())
+            return;
+
+        buffer_ += record;
+
+        if (buffer_.size() >= settings_.flushSize ||
+            std::chrono::duration<double>(Clock::now() - lastFlush_).count() >=
+                settings_.flushInterval)
+            flush();
+    }
+
+    void flush()
+    {
+        lastFlush_ = Clock::now();
+
+        if (buffer_.empty() || !file_.is_open())
+            return;
+
+        file_ << buffer_;
+        file_.flush();
+        buffer_.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Settings settings_;
+    std::ofstream file_;
+    std::string buffer_;
+    Clock::time_point lastFlush_{ Clock::now() };
+};
+
+} // namespace lineage
+
+#endif
@@ -2,11 +2,15 @@
 #ifndef LINEAGE_PROBLEM_GRAPH_HXX
 #define LINEAGE_PROBLEM_GRAPH_HXX
 
+#include <memory>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
-#include <andres/graph/graph.hxx>
-
+#include "frame-graph.hxx"
+#include "optimization-log.hxx"
 #include "problem.hxx"
+#include "thread-pool.hxx"
 #include <levinkov/timer.hxx>
 
 namespace lineage {
@@ -14,7 +18,7 @@ namespace lineage {
 class ProblemGraph
 {
 public:
-    typedef andres::graph::Graph<> Graph;
+    typedef FrameGraph Graph;
 
     template <class EdgeLabels>
     struct SubgraphWithoutCutAndInterFrameEdges
@@ -81,73 +85,114 @@ public:
     ProblemGraph(Problem const& problem)
       : problem_(problem)
     {
+        // nodes by frame, and node indices of the edges.
+        std::vector<size_t> frames(problem.nodes.size());
+        std::vector<size_t> frameBegin;
         for (size_t j = 0; j < problem.nodes.size(); ++j) {
-            auto const& node = problem.nodes[j];
-            if (node.t >= nodeIndicesInFrame_.size())
-                nodeIndicesInFrame_.resize(node.t + 1);
-
-            nodeIndicesInFrame_[node.t].push_back(j);
+            frames[j] = problem.nodes[j].t;
+            if (frames[j] + 2 > frameBegin.size())
+                frameBegin.resize(frames[j] + 2, 0);
+            ++frameBegin[frames[j] + 1];
         }
+        for (size_t t = 1; t < frameBegin.size(); ++t)
+            frameBegin[t] += frameBegin[t - 1];
 
-        numberOfFrames_ = nodeIndicesInFrame_.size();
-
-        graph_.insertVertices(problem.nodes.size());
+        numberOfFrames_ = frameBegin.empty() ? 0 : frameBegin.size() - 1;
 
-        edgeIndicesInFrame_.resize(numberOfFrames_);
-        edgeIndicesFromFrame_.resize(numberOfFrames_ - 1);
+        std::vector<size_t> nodes(problem.nodes.size());
+        {
+            auto position = frameBegin;
+            for (size_t j = 0; j < problem.nodes.size(); ++j)
+                nodes[position[frames[j]]++] = j;
+        }
 
-        for (size_t j = 0; j < problem.edges.size(); ++j) {
-            auto const& edge = problem.edges[j];
+        auto nodeOf = [&](const int t, const int v) {
+            if (t < 0 || static_cast<size_t>(t) >= numberOfFrames_ ||
+                v < 0 || static_cast<size_t>(v) >=
+                             frameBegin[t + 1] - frameBegin[t])
+                throw std::runtime_error("edge of unknown node.");
+            return nodes[frameBegin[t] + v];
+        };
+
+        // edges in frame t and from frame t to t + 1 (counting sort,
+        // stable).
+        std::vector<std::pair<size_t, size_t>> edges;
+        edges.reserve(problem.edges.size());
+        edgeInFrameBegin_.assign(numberOfFrames_ + 1, 0);
+        edgeFromFrameBegin_.assign(numberOfFrames_ + 1, 0);
+
+        for (auto const& edge : problem.edges) {
+            // validates the frames before they are counted.
+            edges.emplace_back(nodeOf(edge.t0, edge.v0),
+                               nodeOf(edge.t1, edge.v1));
 
             if (edge.t0 == edge.t1)
-                edgeIndicesInFrame_[edge.t0].push_back(j);
+                ++edgeInFrameBegin_[edge.t0 + 1];
             else {
                 if (edge.t0 + 1 != edge.t1)
                     throw std::runtime_error(
                         "edge is not directed to next frame.");
 
-                edgeIndicesFromFrame_[edge.t0].push_back(j);
+                ++edgeFromFrameBegin_[edge.t0 + 1];
             }
+        }
 
-            graph_.insertEdge(nodeIndicesInFrame_[edge.t0][edge.v0],
-                              nodeIndicesInFrame_[edge.t1][edge.v1]);
+        for (size_t t = 0; t < numberOfFrames_; ++t) {
+            edgeInFrameBegin_[t + 1] += edgeInFrameBegin_[t];
+            edgeFromFrameBegin_[t + 1] += edgeFromFrameBegin_[t];
         }
+
+        edgesInFrame_.resize(edgeInFrameBegin_.back());
+        edgesFromFrame_.resize(edgeFromFrameBegin_.back());
+        {
+            auto inFrame = edgeInFrameBegin_;
+            auto fromFrame = edgeFromFrameBegin_;
+            for (size_t j = 0; j < problem.edges.size(); ++j) {
+                auto const& edge = problem.edges[j];
+                if (edge.t0 == edge.t1)
+                    edgesInFrame_[inFrame[edge.t0]++] = j;
+                else
+                    edgesFromFrame_[fromFrame[edge.t0]++] = j;
+            }
+        }
+
+        graph_ = Graph(std::move(frames), edges);
     }
 
     size_t edgeFromFrame(size_t t, size_t j) const
     {
-        return edgeIndicesFromFrame_[t][j];
+        return edgesFromFrame_[edgeFromFrameBegin_[t] + j];
     }
 
     size_t edgeInFrame(size_t t, size_t j) const
     {
-        return edgeIndicesInFrame_[t][j];
+        return edgesInFrame_[edgeInFrameBegin_[t] + j];
     }
 
-    size_t frameOfNode(size_t v) const { return problem_.nodes[v].t; }
+    size_t frameOfNode(size_t v) const { return graph_.frameOfVertex(v); }
 
     Graph const& graph() const { return graph_; }
 
     size_t numberOfEdgesFromFrame(size_t t) const
     {
-        return edgeIndicesFromFrame_[t].size();
+        return edgeFromFrameBegin_[t + 1] - edgeFromFrameBegin_[t];
     }
 
     size_t numberOfEdgesInFrame(size_t t) const
     {
-        return edgeIndicesInFrame_[t].size();
+        return edgeInFrameBegin_[t + 1] - edgeInFrameBegin_[t];
     }
 
     size_t numberOfFrames() const { return numberOfFrames_; }
 
     size_t numberOfNodesInFrame(size_t t) const
     {
-        return nodeIndicesInFrame_[t].size();
+        return graph_.numberOfVerticesInFrame(t);
     }
 
     size_t nodeInFrame(size_t t, size_t j) const
     {
-        return nodeIndicesInFrame_[t][j];
+        return graph_.vertexInFrame(t, j);
     }
 
     Problem const& problem() const { return problem_; }
@@ -156,9 +201,12 @@ private:
     Problem const& problem_;
 
     Graph graph_;
-    std::vector<std::vector<size_t>> edgeIndicesFromFrame_;
-    std::vector<std::vector<size_t>> edgeIndicesInFrame_;
-    std::vector<std::vector<size_t>> nodeIndicesInFrame_;
+
+    // edge indices by frame, in compressed rows.
+    std::vector<size_t> edgesFromFrame_;
+    std::vector<size_t> edgeFromFrameBegin_;
+    std::vector<size_t> edgesInFrame_;
+    std::vector<size_t> edgeInFrameBegin_;
     size_t numberOfFrames_;
 };
 
@@ -166,6 +214,7 @@ struct Data
 {
     Data(ProblemGraph const& __problemGraph)
       : problemGraph(__problemGraph)
+      , threadPool(ThreadPool::shared())
     {
     }
 
@@ -176,8 +225,14 @@ struct Data
     size_t maxDistance;
     std::vector<double> costs;
     bool enforceBifurcationConstraint;
+    bool incrementalReproposal{ false }; // GLA: see forEachDependentEdge
+    size_t maxBatchSize{ 64 };           // BGLA: see selectBatch
+    bool parallelBipartitions{ false };  // KLB: see improvePairsInParallel
+    size_t numberOfMoveCandidates{ 0 };  // KLB: see proposeMoveByGain
     std::string solutionName;
     levinkov::Timer timer;
+    OptimizationLog log;
+    std::shared_ptr<ThreadPool> threadPool; // shared by all optimizers.
 };
 
 } // namespace lineage
@@ -3,9 +3,22 @@
 #define LINEAGE_PROBLEM_HXX
 
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <thread>
 #include <vector>
 #include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 namespace lineage {
@@ -79,14 +92,610 @@ size_t loadEdges(const std::string& fileName, Problem& problem)
     return counter;
 }
 
+// Sequential reader of a problem, one frame at a time, such that only the
+// current frame has to be kept in memory. Requires the nodes file to be
+// sorted by t and the edges file to be sorted by max(t0, t1).
+class FrameReader
+{
+public:
+    FrameReader(const std::string& nodesFileName, const std::string& edgesFileName) :
+        nodesFile_(nodesFileName),
+        edgesFile_(edgesFileName)
+    {
+        if (!nodesFile_)
+            throw std::runtime_error("could not open " + nodesFileName + ".");
+        if (!edgesFile_)
+            throw std::runtime_error("could not open " + edgesFileName + ".");
+
+        readNode();
+        readEdge();
+    }
+
+    // frame of the last call to read().
+    int frame() const
+    {
+        return frame_;
+    }
+
+    // reads the nodes of the next frame and all edges within it or from the
+    // previous frame. Returns false if both files are exhausted.
+    bool read(std::vector<Node>& nodes, std::vector<Edge>& edges)
+    {
+        nodes.clear();
+        edges.clear();
+
+        if (!hasNode_ && !hasEdge_)
+            return false;
+
+        ++frame_;
+
+        while (hasNode_ && node_.t <= frame_)
+        {
+            if (node_.t < frame_)
+                throw std::runtime_error("nodes are not sorted by frame.");
+
+            nodes.push_back(node_);
+            readNode();
+        }
+
+        while (hasEdge_ && std::max(edge_.t0, edge_.t1) <= frame_)
+        {
+            if (std::max(edge_.t0, edge_.t1) < frame_)
+                throw std::runtime_error("edges are not sorted by frame.");
+
+            edges.push_back(edge_);
+            readEdge();
+        }
+
+        return true;
+    }
+
+private:
+    void readNode()
+    {
+        hasNode_ = static_cast<bool>(nodesFile_ >> node_.t >> node_.id >> node_.cx >> node_.cy >> node_.probability_birth_termination);
+    }
+
+    void readEdge()
+    {
+        hasEdge_ = static_cast<bool>(edgesFile_ >> edge_.t0 >> edge_.v0 >> edge_.t1 >> edge_.v1 >> edge_.weight);
+    }
+
+    std::ifstream nodesFile_;
+    std::ifstream edgesFile_;
+    Node node_;
+    Edge edge_;
+    bool hasNode_ { false };
+    bool hasEdge_ { false };
+    int frame_ { -1 };
+};
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& fileName)
+    {
+        const int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("could not open " + fileName + ".");
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("could not stat " + fileName + ".");
+        }
+
+        size_ = status.st_size;
+        if (size_ > 0)
+        {
+            mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping_ == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("could not map " + fileName + " into memory.");
+            }
+        }
+
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (size_ > 0)
+            ::munmap(mapping_, size_);
+    }
+
+    const char* begin() const { return static_cast<const char*>(mapping_); }
+    const char* end() const { return begin() + size_; }
+    size_t size() const { return size_; }
+
+private:
+    void* mapping_ { nullptr };
+    size_t size_ { 0 };
+};
+
+// Binary problem format.
+//
+// A binary problem file holds nodes, edges and node_offsets of a Problem
+// in a single file that is memory-mapped on loading. The layout is
+//
+//   BinaryProblemHeader
+//   double   probability_birth_termination[numberOfNodes]
+//   double   weight[numberOfEdges]
+//   uint64_t node_offsets[numberOfNodeOffsets]
+//   int32_t  t[numberOfNodes], id[..], cx[..], cy[..]
+//   int32_t  t0[numberOfEdges], v0[..], t1[..], v1[..]
+//
+// i.e. one array per member (structure of arrays), ordered by element size
+// such that every array is naturally aligned. All values are stored in the
+// byte order of the machine that wrote the file; files of the opposite
+// byte order are rejected.
+struct BinaryProblemHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t numberOfNodes;
+    uint64_t numberOfEdges;
+    uint64_t numberOfNodeOffsets;
+};
+
+constexpr char BINARY_PROBLEM_MAGIC[8] = { 'L', 'I', 'N', 'E', 'A', 'G', 'E', 'B' };
+constexpr uint32_t BINARY_PROBLEM_VERSION = 1;
+constexpr uint32_t BINARY_PROBLEM_BYTE_ORDER_MARK = 0x01020304;
+
+// whether a file of fileSize bytes holds exactly the header and the arrays
+// it announces. The counts are read from the file and thus untrusted: each is
+// bounded by the remaining size before it is multiplied, such that a corrupt
+// header cannot wrap the computation around.
+inline
+bool binaryProblemHasFileSize(const BinaryProblemHeader& header, size_t fileSize)
+{
+    if (fileSize < sizeof(BinaryProblemHeader))
+        return false;
+
+    size_t remaining = fileSize - sizeof(BinaryProblemHeader);
+    auto consume = [&](uint64_t count, size_t elementSize) {
+        if (count > remaining / elementSize)
+            return false;
+        remaining -= count * elementSize;
+        return true;
+    };
+
+    return consume(header.numberOfNodes, sizeof(double) + 4 * sizeof(int32_t))
+        && consume(header.numberOfEdges, sizeof(double) + 4 * sizeof(int32_t))
+        && consume(header.numberOfNodeOffsets, sizeof(uint64_t))
+        && remaining == 0;
+}
+
+inline
+bool isBinaryProblem(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ifstream::binary);
+
+    char magic[sizeof(BINARY_PROBLEM_MAGIC)];
+    if (!file.read(magic, sizeof(magic)))
+        return false;
+
+    return std::memcmp(magic, BINARY_PROBLEM_MAGIC, sizeof(magic)) == 0;
+}
+
+inline
+void saveBinaryProblem(const std::string& fileName, const Problem& problem)
+{
+    BinaryProblemHeader header;
+    std::memcpy(header.magic, BINARY_PROBLEM_MAGIC, sizeof(header.magic));
+    header.version = BINARY_PROBLEM_VERSION;
+    header.byteOrderMark = BINARY_PROBLEM_BYTE_ORDER_MARK;
+    header.numberOfNodes = problem.nodes.size();
+    header.numberOfEdges = problem.edges.size();
+    header.numberOfNodeOffsets = problem.node_offsets.size();
+
+    std::ofstream file(fileName, std::ofstream::binary);
+    if (!file)
+        throw std::runtime_error("could not open " + fileName + " for writing.");
+
+    auto writeArray = [&](const void* data, size_t size) {
+        file.write(reinterpret_cast<const char*>(data), size);
+    };
+
+    writeArray(&header, sizeof(header));
+
+    std::vector<double> doubles;
+    std::vector<int32_t> ints;
+
+    doubles.reserve(problem.nodes.size());
+    for (auto const& node : problem.nodes)
+        doubles.push_back(node.probability_birth_termination);
+    writeArray(doubles.data(), doubles.size() * sizeof(double));
+
+    doubles.clear();
+    for (auto const& edge : problem.edges)
+        doubles.push_back(edge.weight);
+    writeArray(doubles.data(), doubles.size() * sizeof(double));
+
+    std::vector<uint64_t> offsets(problem.node_offsets.begin(), problem.node_offsets.end());
+    writeArray(offsets.data(), offsets.size() * sizeof(uint64_t));
+
+    for (auto member : { &Node::t, &Node::id, &Node::cx, &Node::cy })
+    {
+        ints.clear();
+        for (auto const& node : problem.nodes)
+            ints.push_back(node.*member);
+        writeArray(ints.data(), ints.size() * sizeof(int32_t));
+    }
+
+    for (auto member : { &Edge::t0, &Edge::v0, &Edge::t1, &Edge::v1 })
+    {
+        ints.clear();
+        for (auto const& edge : problem.edges)
+            ints.push_back(edge.*member);
+        writeArray(ints.data(), ints.size() * sizeof(int32_t));
+    }
+
+    if (!file)
+        throw std::runtime_error("failed to write " + fileName + ".");
+
+    file.close();
+}
+
+inline
+Problem loadBinaryProblem(const std::string& fileName)
+{
+    const MappedFile mappedFile(fileName);
+    if (mappedFile.size() < sizeof(BinaryProblemHeader))
+        throw std::runtime_error(fileName + " is not a binary problem file.");
+
+    const size_t fileSize = mappedFile.size();
+    const char* begin = mappedFile.begin();
+
+    BinaryProblemHeader header;
+    std::memcpy(&header, begin, sizeof(header));
+
+    if (std::memcmp(header.magic, BINARY_PROBLEM_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error(fileName + " is not a binary problem file.");
+    if (header.byteOrderMark != BINARY_PROBLEM_BYTE_ORDER_MARK)
+        throw std::runtime_error(fileName + " was written with a different byte order.");
+    if (header.version != BINARY_PROBLEM_VERSION)
+        throw std::runtime_error(fileName + " has unsupported binary problem version " + std::to_string(header.version) + ".");
+    if (!binaryProblemHasFileSize(header, fileSize))
+        throw std::runtime_error(fileName + " is truncated or corrupt.");
+
+    const auto nNodes = header.numberOfNodes;
+    const auto nEdges = header.numberOfEdges;
+
+    auto position = begin + sizeof(header);
+    auto doubles = [&](size_t n) {
+        auto p = reinterpret_cast<const double*>(position);
+        position += n * sizeof(double);
+        return p;
+    };
+    auto ints = [&](size_t n) {
+        auto p = reinterpret_cast<const int32_t*>(position);
+        position += n * sizeof(int32_t);
+        return p;
+    };
+
+    auto nodeProbabilities = doubles(nNodes);
+    auto edgeWeights = doubles(nEdges);
+
+    auto offsets = reinterpret_cast<const uint64_t*>(position);
+    position += header.numberOfNodeOffsets * sizeof(uint64_t);
+
+    // node_offsets index the nodes by frame: 0, ..., nNodes, non-decreasing.
+    const auto nOffsets = header.numberOfNodeOffsets;
+    if (nOffsets == 0 || offsets[0] != 0 || offsets[nOffsets - 1] != nNodes)
+        throw std::runtime_error(fileName + " is truncated or corrupt.");
+    for (size_t i = 1; i < nOffsets; ++i)
+        if (offsets[i] < offsets[i - 1])
+            throw std::runtime_error(fileName + " is truncated or corrupt.");
+
+    auto nodeT = ints(nNodes);
+    auto nodeId = ints(nNodes);
+    auto nodeCx = ints(nNodes);
+    auto nodeCy = ints(nNodes);
+
+    auto edgeT0 = ints(nEdges);
+    auto edgeV0 = ints(nEdges);
+    auto edgeT1 = ints(nEdges);
+    auto edgeV1 = ints(nEdges);
+
+    Problem problem;
+
+    problem.nodes.resize(nNodes);
+    for (size_t i = 0; i < nNodes; ++i)
+        problem.nodes[i] = { nodeT[i], nodeId[i], nodeCx[i], nodeCy[i], nodeProbabilities[i] };
+
+    problem.edges.resize(nEdges);
+    for (size_t i = 0; i < nEdges; ++i)
+        problem.edges[i] = { edgeT0[i], edgeV0[i], edgeT1[i], edgeV1[i], edgeWeights[i] };
+
+    problem.node_offsets.assign(offsets, offsets + header.numberOfNodeOffsets);
+
+    return problem;
+}
+
+// Parallel text loader.
+//
+// The file is mapped into memory and split into line-aligned chunks that are
+// parsed concurrently with the locale-independent number parsers below. The
+// per-chunk results are concatenated in file order, so the result is
+// identical to that of loadNodes/loadEdges for well-formed files.
+namespace detail {
+
+inline
+const char* skipWhitespace(const char* p, const char* end)
+{
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+    return p;
+}
+
+inline
+const char* parseInt(const char* p, const char* end, int& value)
+{
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    if (p == end || *p < '0' || *p > '9')
+        return nullptr;
+
+    // tokens out of the range of int are malformed, like any other.
+    const long long limit = negative
+        ? -static_cast<long long>(std::numeric_limits<int>::min())
+        : std::numeric_limits<int>::max();
+
+    long long v = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+        const int digit = *p - '0';
+        if (v > (limit - digit) / 10)
+            return nullptr;
+
+        v = 10 * v + digit;
+    }
+
+    value = static_cast<int>(negative ? -v : v);
+    return p;
+}
+
+// Numbers with at most 19 significant digits and a decimal exponent of
+// magnitude at most 22 whose mantissa is exactly representable are converted
+// with a single correctly rounded multiplication or division (Clinger's fast
+// path). All other numbers fall back to std::strtod.
+inline
+const char* parseDouble(const char* p, const char* end, double& value)
+{
+    static const double powersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* begin = p;
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool exact = true;
+    bool any = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+        any = true;
+        if (digits < 19)
+        {
+            mantissa = 10 * mantissa + (*p - '0');
+            if (mantissa != 0)
+                ++digits;
+        }
+        else
+        {
+            ++exponent;
+            exact = false;
+        }
+    }
+
+    if (p != end && *p == '.')
+    {
+        ++p;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p)
+        {
+            any = true;
+            if (digits < 19)
+            {
+                mantissa = 10 * mantissa + (*p - '0');
+                if (mantissa != 0)
+                    ++digits;
+                --exponent;
+            }
+            else
+                exact = false;
+        }
+    }
+
+    if (!any)
+        return nullptr;
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        int e = 0;
+        const char* q = parseInt(p + 1, end, e);
+        if (q == nullptr)
+            return nullptr;
+
+        exponent += e;
+        p = q;
+    }
+
+    if (exact && mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        value = static_cast<double>(mantissa);
+        if (exponent < 0)
+            value /= powersOf10[-exponent];
+        else
+            value *= powersOf10[exponent];
+
+        if (negative)
+            value = -value;
+    }
+    else
+        value = std::strtod(std::string(begin, p).c_str(), nullptr);
+
+    return p;
+}
+
+inline
+const char* parseRecord(const char* p, const char* end, Node& node)
+{
+    p = parseInt(skipWhitespace(p, end), end, node.t);
+    if (p) p = parseInt(skipWhitespace(p, end), end, node.id);
+    if (p) p = parseInt(skipWhitespace(p, end), end, node.cx);
+    if (p) p = parseInt(skipWhitespace(p, end), end, node.cy);
+    if (p) p = parseDouble(skipWhitespace(p, end), end, node.probability_birth_termination);
+    return p;
+}
+
+inline
+const char* parseRecord(const char* p, const char* end, Edge& edge)
+{
+    p = parseInt(skipWhitespace(p, end), end, edge.t0);
+    if (p) p = parseInt(skipWhitespace(p, end), end, edge.v0);
+    if (p) p = parseInt(skipWhitespace(p, end), end, edge.t1);
+    if (p) p = parseInt(skipWhitespace(p, end), end, edge.v1);
+    if (p) p = parseDouble(skipWhitespace(p, end), end, edge.weight);
+    return p;
+}
+
+template<class RECORD>
+std::vector<RECORD> parseChunk(const char* p, const char* end)
+{
+    std::vector<RECORD> records;
+    records.reserve((end - p) / 16);
+
+    RECORD record;
+    while ((p = skipWhitespace(p, end)) != end)
+    {
+        p = parseRecord(p, end, record);
+        if (p == nullptr)
+            throw std::runtime_error("malformed record.");
+
+        records.push_back(record);
+    }
+
+    return records;
+}
+
+template<class RECORD>
+std::vector<RECORD> parseFileParallel(const std::string& fileName, size_t numberOfThreads)
+{
+    // chunks smaller than this are not worth a thread.
+    constexpr size_t minimumChunkSize = 1 << 16;
+
+    const MappedFile file(fileName);
+
+    if (numberOfThreads == 0)
+        numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    numberOfThreads = std::max<size_t>(1, std::min(numberOfThreads, file.size() / minimumChunkSize));
+
+    // line-aligned chunk boundaries.
+    std::vector<const char*> boundaries { file.begin() };
+    for (size_t i = 1; i < numberOfThreads; ++i)
+    {
+        const char* p = std::max(boundaries.back(), file.begin() + i * (file.size() / numberOfThreads));
+        p = std::find(p, file.end(), '\n');
+        if (p != file.end())
+            ++p;
+        boundaries.push_back(p);
+    }
+    boundaries.push_back(file.end());
+
+    std::vector<std::future<std::vector<RECORD>>> handles;
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+        handles.emplace_back(std::async(std::launch::async, &parseChunk<RECORD>, boundaries[i], boundaries[i + 1]));
+
+    std::vector<std::vector<RECORD>> chunks;
+    size_t numberOfRecords = 0;
+    for (auto& handle : handles)
+    {
+        try
+        {
+            chunks.emplace_back(handle.get());
+        }
+        catch (std::runtime_error& e)
+        {
+            throw std::runtime_error(fileName + ": " + e.what());
+        }
+        numberOfRecords += chunks.back().size();
+    }
+
+    std::vector<RECORD> records;
+    records.reserve(numberOfRecords);
+    for (auto const& chunk : chunks)
+        records.insert(records.end(), chunk.begin(), chunk.end());
+
+    return records;
+}
+
+} // namespace detail
+
+// Multi-threaded counterpart of loadNodes. numberOfThreads = 0 uses all
+// hardware threads.
+inline
+size_t loadNodesParallel(const std::string& fileName, Problem& problem, size_t numberOfThreads = 0)
+{
+    problem.nodes = detail::parseFileParallel<Node>(fileName, numberOfThreads);
+
+    problem.node_offsets.clear();
+    problem.node_offsets.push_back(0);
+
+    for (size_t i = 0; i < problem.nodes.size(); ++i)
+        if (problem.nodes[i].t == problem.node_offsets.size())
+            problem.node_offsets.push_back(i);
+
+    problem.node_offsets.push_back(problem.nodes.size());
+
+    return problem.nodes.size();
+}
+
+// Multi-threaded counterpart of loadEdges.
+inline
+size_t loadEdgesParallel(const std::string& fileName, Problem& problem, size_t numberOfThreads = 0)
+{
+    problem.edges = detail::parseFileParallel<Edge>(fileName, numberOfThreads);
+
+    return problem.edges.size();
+}
+
+// Loads a problem from text files nodes.csv and edges.csv. If the nodes file
+// is a binary problem file (cf. saveBinaryProblem), the whole problem is
+// loaded from it and edgesFileName is ignored.
 inline
 Problem loadProblem(const std::string& nodesFileName, const std::string& edgesFileName)
 {
+    if (isBinaryProblem(nodesFileName))
+        return loadBinaryProblem(nodesFileName);
+
     Problem problem;
 
-    loadNodes(nodesFileName, problem);
+    loadNodesParallel(nodesFileName, problem);
     
-    loadEdges(edgesFileName, problem);
+    loadEdgesParallel(edgesFileName, problem);
     
     return problem;
 }
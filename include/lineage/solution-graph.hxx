@@ -18,7 +18,7 @@ namespace lineage {
 
 class SolutionGraph {
 public:
-    typedef andres::graph::Graph<> Graph;
+    typedef ProblemGraph::Graph Graph;
     typedef andres::graph::Digraph<> Digraph;
 
     SolutionGraph(const ProblemGraph& problemGraph, const Solution& solution) :
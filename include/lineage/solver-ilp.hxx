@@ -2,16 +2,20 @@
 #ifndef LINEAGE_SOLVER_ILP_CALLBACK_HXX
 #define LINEAGE_SOLVER_ILP_CALLBACK_HXX
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
 #include <vector>
-#include <stack>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 
 #include <andres/graph/components.hxx>
-#include <andres/graph/paths.hxx>
-#include <andres/graph/shortest-paths.hxx>
 
 #include <levinkov/timer.hxx>
 
@@ -27,7 +31,7 @@
 namespace lineage {
 
 template<class ILP>
-Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .0, double costBirth = .0, bool enforceBifurcationConstraint = false, bool add3WheelConstraints = false, bool initialize = false, std::string solutionName = "ilp")
+Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .0, double costBirth = .0, bool enforceBifurcationConstraint = false, bool add3WheelConstraints = false, bool initialize = false, std::string solutionName = "ilp", OptimizationLog::Settings logSettings = {})
 {
 
     class Callback: public ILP::Callback
@@ -36,9 +40,9 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
         Callback(ILP& solver, Data& data) :
             ILP::Callback(solver),
             data_(data),
-            coefficients_(data.costs.size()),
-            variables_(data.costs.size()),
-            edgeLabels_(data.costs.size())
+            labels_(data.costs.size()),
+            edgeLabels_(data.costs.size()),
+            changedFrames_(data.problemGraph.numberOfFrames(), false)
         {
 
         }
@@ -46,20 +50,8 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
 
         void computeFeasibleSolution() override
         {
-            using BranchingOptimizer = lineage::heuristics::branching::HungarianBranching<
-            lineage::heuristics::PartitionGraph>;
-
-            auto pgraph = lineage::heuristics::PartitionGraph(data_, edgeLabels_);
-
-            auto branchingOptimizer = BranchingOptimizer(pgraph);
-            branchingOptimizer.optimize();
-
-            pgraph.branchingLabels_.clear();
-            pgraph.branchingLabels_.reserve(pgraph.numberOfEdges());
-
-            for (auto&& label : branchingOptimizer.getSolution()) {
-                pgraph.branchingLabels_.emplace_back(label);
-            }
+            updatePartitionGraph();
+            auto const& pgraph = *partitionGraph_;
 
             // set feasible solution
             for (size_t t = 0; t < data_.problemGraph.numberOfFrames(); ++t) 
@@ -165,27 +157,35 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
             levinkov::Timer t_separation;
             t_separation.start();
 
+            // the labels are read once, as the callback of the solver must not be called from other threads
+            for (size_t i = 0; i < labels_.size(); ++i)
+                labels_[i] = this->label(i);
+
+            // The components are rebuilt for all frames, including those whose labels are unchanged (cache hits),
+            // as their labels index cuts_ and the feasible labels below.
             componentsInFrame_.build(
                 data_.problemGraph.graph(),
                 SubgraphWithoutCutAndInterFrameEdges(data_.problemGraph.problem(), EdgeLabels(*this))
             );
 
-            auto nSpaceCycle = separateAndAddSpaceCycleConstraints();
+            separateByFrame();
+
+            auto nSpaceCycle = addLazyConstraints(SpaceCycle);
             std::cout << ' ' << nSpaceCycle << std::flush;
             stream << ' ' << nSpaceCycle;
 
-            auto nSpacetimeCycle = separateAndAddSpacetimeCycleConstraints();
+            auto nSpacetimeCycle = addLazyConstraints(SpacetimeCycle);
             std::cout << ' ' << nSpacetimeCycle << std::flush;
             stream << ' ' << nSpacetimeCycle;
 
-            auto nMorality = separateAndAddMoralityConstraints();
+            auto nMorality = addLazyConstraints(Morality);
             std::cout << ' ' << nMorality << std::flush;
             stream << ' ' << nMorality;
 
             size_t nTermination = 0;
             if (data_.costTermination > 0.0)
             {
-                nTermination = separateAndAddTerminationConstraints();
+                nTermination = addLazyConstraints(Termination);
                 std::cout << ' ' << nTermination << std::flush;
                 stream << ' ' << nTermination;
             }
@@ -193,7 +193,7 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
             size_t nBirth = 0;
             if (data_.costBirth > 0.0)
             {
-                nBirth = separateAndAddBirthConstraints();
+                nBirth = addLazyConstraints(Birth);
                 std::cout << ' ' << nBirth << std::flush;
                 stream << ' ' << nBirth;
             }
@@ -202,7 +202,7 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
             size_t nBifurcation = 0;
             if (data_.enforceBifurcationConstraint)
             {
-                nBifurcation = separateAndAddBifurcationConstraints();
+                nBifurcation = addLazyConstraints(Bifurcation);
                 std::cout << ' ' << nBifurcation << std::flush;
                 stream << ' ' << nBifurcation;
             }
@@ -211,27 +211,25 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
             t_separation.stop();
             data_.timer.stop(); // not keeping time for writing log
 
-            stream << " " << t_separation.get_elapsed_seconds() << std::endl;
-            std::cout << " " << t_separation.get_elapsed_seconds() << std::endl;
+            // frames skipped and separated
+            auto const numberOfCacheMisses = cache_.size() - numberOfCacheHits_;
+            stream << " " << t_separation.get_elapsed_seconds() << " " << numberOfCacheHits_ << " " << numberOfCacheMisses << std::endl;
+            std::cout << " " << t_separation.get_elapsed_seconds() << " " << numberOfCacheHits_ << " " << numberOfCacheMisses << std::endl;
 
-            {
-                std::ofstream file(data_.solutionName + "-optimization-log.txt", std::ofstream::out | std::ofstream::app);
-                file << stream.str();
-                file.close();
-            }
+            data_.log.append(stream.str());
 
             n = n + nBifurcation;
             if (n == 0)
             {
                 std::ofstream file(data_.solutionName + "-fragment-edge-labels-FEASIBLE-" + std::to_string(numberOfFeasibleSolutions_) + ".txt");
                 for (size_t e = 0; e < data_.problemGraph.graph().numberOfEdges(); ++e)
-                    file << (this->label(e) > .5 ? 1 : 0) << std::endl;
+                    file << (labels_[e] > .5 ? 1 : 0) << std::endl;
                 
                 file.close();
 
                 file.open(data_.solutionName + "-variables-values-FEASIBLE-" + std::to_string(numberOfFeasibleSolutions_) + ".txt");
                 for (size_t i = 0; i < data_.costs.size(); ++i)
-                    file << (this->label(i) > .5 ? 1 : 0) << std::endl;
+                    file << (labels_[i] > .5 ? 1 : 0) << std::endl;
                 
                 file.close();
 
@@ -242,13 +240,7 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
 
             data_.timer.start(); // resume keeping time
 
-            // compute feasible edge labels
-            ComponentsType components;
-            components.build(
-                data_.problemGraph.graph(),
-                SubgraphWithoutCutAndInterFrameEdges(data_.problemGraph.problem(), EdgeLabels(*this))
-            );
-
+            // compute feasible edge labels (componentsInFrame_ is that of the current labels)
             for (size_t t = 0; t < data_.problemGraph.numberOfFrames(); ++t)
             {
                 for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(t); ++i)
@@ -258,10 +250,12 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
                     auto v1 = data_.problemGraph.graph().vertexOfEdge(e, 1);
 
                     // if connected within frame
-                    if (components.areConnected(v0,v1))
-                        edgeLabels_[e] = 0;
-                    else
-                        edgeLabels_[e] = 1;
+                    const double label = componentsInFrame_.areConnected(v0,v1) ? 0 : 1;
+                    if (edgeLabels_[e] != label)
+                    {
+                        edgeLabels_[e] = label;
+                        changedFrames_[t] = true;
+                    }
                 }
             }
         }
@@ -278,7 +272,7 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
 
             int operator[](size_t edge) const
             {
-                return callback_.label(edge) > .5 ? 1 : 0;
+                return callback_.labels_[edge] > .5 ? 1 : 0;
             }
 
         private:
@@ -286,484 +280,717 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
         };
 
         typedef ProblemGraph::SubgraphWithoutCutAndInterFrameEdges<EdgeLabels> SubgraphWithoutCutAndInterFrameEdges;
-        typedef ProblemGraph::SubgraphOfTwoFramesWithoutCut<EdgeLabels> SubgraphOfTwoFramesWithoutCut;
 
-        size_t separateAndAddSpaceCycleConstraints()
+        enum Separator
+        {
+            SpaceCycle,
+            SpacetimeCycle,
+            Morality,
+            Termination,
+            Birth,
+            Bifurcation,
+            NumberOfSeparators
+        };
+
+        // constraints sum_j coefficients[j] * x[variables[j]] >= lowerBound, in the order found
+        struct LazyConstraints
         {
+            void add(const size_t variable, const double coefficient)
+            {
+                variables.push_back(variable);
+                coefficients.push_back(coefficient);
+            }
+
+            void close(const double lowerBound)
+            {
+                begin.push_back(variables.size());
+                lowerBounds.push_back(lowerBound);
+            }
+
+            // drop the variables added since the last close
+            void discard()
+            {
+                variables.resize(begin.back());
+                coefficients.resize(begin.back());
+            }
+
+            void clear()
+            {
+                variables.clear();
+                coefficients.clear();
+                begin.assign(1, 0);
+                lowerBounds.clear();
+            }
+
+            size_t size() const
+            {
+                return lowerBounds.size();
+            }
+
+            std::vector<size_t> variables;
+            std::vector<double> coefficients;
+            std::vector<size_t> begin; // by constraint, plus the end
+            std::vector<double> lowerBounds;
+        };
+
+        // constraints separated for a frame, and the labels they were separated from
+        struct FrameCache
+        {
+            std::array<LazyConstraints, NumberOfSeparators> constraints;
+
+            std::vector<unsigned char> signature; // labels read by the separators of the frame, cf. signFrame
+            std::uint64_t fingerprint { 0 };      // hash of the signature
+            bool valid { false };
+            bool hit { false };                   // in the current call
+        };
+
+        // state of the separation of one block of consecutive frames
+        struct Workspace
+        {
+            std::vector<size_t> components; // in frames t and t + 1 without cut edges, by vertex
+            std::vector<size_t> queue;
             std::deque<size_t> path;
-            std::vector<ptrdiff_t> buffer;
+            std::vector<std::pair<size_t, size_t>> violatedEdges; // first vertex and edge
+            std::vector<std::pair<size_t, size_t>> successors;    // component of frame t + 1 and vertex of frame t
+            std::vector<std::pair<size_t, size_t>> pairs;         // of vertices of frame t
+            std::vector<size_t> targets;    // of growSearchTree
+            std::vector<size_t> parent;     // in the search tree of growSearchTree, by vertex
+            std::vector<size_t> cut;
+            std::vector<unsigned char> signature;
+
+            // a vertex is visited (marked, seen) in the current search if visited[v] (marked[v], seen[v]) == epoch
+            std::vector<size_t> visited;
+            std::vector<size_t> marked;
+            std::vector<size_t> seen;
+            size_t epoch { 0 };
+        };
+
+        // Separate all frames in parallel, by blocks of consecutive frames. The constraints are buffered
+        // by frame and separator and added by addLazyConstraints in the order of the frames, such that
+        // they do not depend on the number of threads. Frames whose labels are unchanged since their last
+        // separation are not separated again.
+        void separateByFrame()
+        {
+            auto const numberOfVertices = data_.problemGraph.graph().numberOfVertices();
+            auto const numberOfFrames = data_.problemGraph.numberOfFrames();
+            auto const numberOfBlocks = std::max<size_t>(1, std::min(numberOfFrames, data_.threadPool->numberOfThreads()));
+
+            if (data_.enforceBifurcationConstraint)
+                findComponentCuts();
+
+            cache_.resize(numberOfFrames);
+            workspaces_.resize(numberOfBlocks);
+            data_.threadPool->parallelFor(numberOfBlocks, [&](size_t i)
+            {
+                auto& workspace = workspaces_[i];
+
+                if (workspace.components.size() != numberOfVertices)
+                {
+                    workspace.components.resize(numberOfVertices);
+                    workspace.parent.resize(numberOfVertices);
+                    workspace.visited.assign(numberOfVertices, 0);
+                    workspace.marked.assign(numberOfVertices, 0);
+                    workspace.seen.assign(numberOfVertices, 0);
+                    workspace.epoch = 0;
+                }
+
+                for (size_t t = i * numberOfFrames / numberOfBlocks; t < (i + 1) * numberOfFrames / numberOfBlocks; ++t)
+                {
+                    auto& frame = cache_[t];
+
+                    signFrame(t, workspace.signature);
+
+                    std::uint64_t fingerprint = 14695981039346656037ull; // FNV-1a
+                    for (auto const label : workspace.signature)
+                        fingerprint = (fingerprint ^ label) * 1099511628211ull;
+
+                    frame.hit = frame.valid && frame.fingerprint == fingerprint && frame.signature == workspace.signature;
+                    if (frame.hit)
+                        continue;
+
+                    frame.signature.swap(workspace.signature);
+                    frame.fingerprint = fingerprint;
+                    frame.valid = true;
+                    for (auto& constraints : frame.constraints)
+                        constraints.clear();
+
+                    separateFrame(t, workspace);
+                }
+            });
+
+            numberOfCacheHits_ = 0;
+            size_t numberOfNewConstraints = 0;
+            for (auto const& frame : cache_)
+                if (frame.hit)
+                    ++numberOfCacheHits_;
+                else
+                    for (auto const& constraints : frame.constraints)
+                        numberOfNewConstraints += constraints.size();
+
+            // The constraints of frames whose labels are unchanged since their last separation (cache hits) have
+            // been added before. As the solver may still present a solution that violates them, they are added
+            // again if no other frame has violated constraints.
+            addCachedConstraints_ = numberOfNewConstraints == 0;
+        }
+
+        // labels read by the separators of frame t: those of the edges in frames t and t + 1, of the edges from
+        // frame t - 1 to frame t + 1, and of termination and birth of the nodes of frame t
+        void signFrame(size_t const t, std::vector<unsigned char>& signature) const
+        {
+            auto const numberOfFrames = data_.problemGraph.numberOfFrames();
+            auto add = [&](size_t const i)
+            {
+                signature.push_back(labels_[i] > .5 ? 1 : 0);
+            };
+
+            signature.clear();
+
+            for (size_t tt = t; tt < std::min(t + 2, numberOfFrames); ++tt)
+                for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(tt); ++i)
+                    add(data_.problemGraph.edgeInFrame(tt, i));
+
+            for (size_t tt = t > 0 ? t - 1 : t; tt < std::min(t + 1, numberOfFrames - 1); ++tt)
+                for (size_t i = 0; i < data_.problemGraph.numberOfEdgesFromFrame(tt); ++i)
+                    add(data_.problemGraph.edgeFromFrame(tt, i));
+
+            auto offset = data_.problemGraph.graph().numberOfEdges();
+            if (data_.costTermination > 0.0)
+            {
+                for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+                    add(offset + data_.problemGraph.nodeInFrame(t, j));
+
+                offset += data_.problemGraph.graph().numberOfVertices();
+            }
+
+            if (data_.costBirth > 0.0)
+                for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+                    add(offset + data_.problemGraph.nodeInFrame(t, j));
+        }
+
+        size_t addLazyConstraints(Separator const separator)
+        {
             size_t counter = 0;
 
-            std::vector<char> seen(data_.problemGraph.graph().numberOfVertices());
-            std::vector<ptrdiff_t> parent(data_.problemGraph.graph().numberOfVertices());
-            std::vector<double> cost(data_.problemGraph.graph().numberOfVertices());
-            std::vector<size_t> dist(data_.problemGraph.graph().numberOfVertices());
+            for (auto const& frame : cache_)
+            {
+                if (frame.hit && !addCachedConstraints_)
+                    continue;
+
+                auto const& constraints = frame.constraints[separator];
+
+                for (size_t i = 0; i < constraints.size(); ++i)
+                    this->addLazyConstraint(
+                        constraints.variables.begin() + constraints.begin[i],
+                        constraints.variables.begin() + constraints.begin[i + 1],
+                        constraints.coefficients.begin() + constraints.begin[i],
+                        constraints.lowerBounds[i],
+                        std::numeric_limits<double>::infinity()
+                    );
 
-            // separate cycles between consecutive frames
-            for (size_t t = 0; t < data_.problemGraph.numberOfFrames() - 1; ++t)
+                counter += constraints.size();
+            }
+
+            return counter;
+        }
+
+        // constraints of frame t, and of the edges from frame t to frame t + 1
+        void separateFrame(size_t const t, Workspace& workspace)
+        {
+            // the connected components of frames t and t + 1 are shared by the cycle and morality separators
+            labelComponentsOfTwoFrames(t, workspace);
+
+            separateCycleConstraints(t, workspace);
+
+            if (t + 1 < data_.problemGraph.numberOfFrames())
             {
-                // do connected components labeling only for frames t and t+1
-                ComponentsType components;
-                components.build(
-                    data_.problemGraph.graph(),
-                    SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t)
-                );
+                separateMoralityConstraints(t, workspace);
 
-                for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(t); ++i)
+                if (data_.costTermination > 0.0)
+                    separateTerminationConstraints(t, workspace);
+            }
+
+            if (data_.costBirth > 0.0 && t > 0)
+                separateBirthConstraints(t, workspace);
+
+            if (data_.enforceBifurcationConstraint && t + 1 < data_.problemGraph.numberOfFrames())
+                separateBifurcationConstraints(t, workspace);
+        }
+
+        // connected components of frames t and t + 1 (of frame t if it is the last) without cut edges, cf.
+        // SubgraphOfTwoFramesWithoutCut. The label of a component is one of its vertices.
+        void labelComponentsOfTwoFrames(size_t const t, Workspace& workspace)
+        {
+            auto const& graph = data_.problemGraph.graph();
+            auto& components = workspace.components;
+
+            ++workspace.epoch;
+            for (auto const tt : { t, t + 1 })
+                for (size_t j = 0; tt < data_.problemGraph.numberOfFrames() && j < data_.problemGraph.numberOfNodesInFrame(tt); ++j)
                 {
-                    auto e = data_.problemGraph.edgeInFrame(t, i);
+                    auto const root = data_.problemGraph.nodeInFrame(tt, j);
+                    if (workspace.visited[root] == workspace.epoch)
+                        continue;
 
-                    auto v0 = data_.problemGraph.graph().vertexOfEdge(e, 0);
-                    auto v1 = data_.problemGraph.graph().vertexOfEdge(e, 1);
-                    
-                    // if an edge violates connectivity as defined by connected components
-                    if (this->label(e) > .5 && components.areConnected(v0, v1))
+                    workspace.visited[root] = workspace.epoch;
+                    components[root] = root;
+                    workspace.queue.assign(1, root);
+
+                    while (!workspace.queue.empty())
                     {
-                        // find the shortest path using BFS
-                        spsp(
-                            data_.problemGraph.graph(),
-                            SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t),
-                            v0, v1, path, buffer
-                        );
-
-                        // skip chord check for triangles
-                        if (path.size() > 3)
+                        auto const v = workspace.queue.back();
+                        workspace.queue.pop_back();
+
+                        // adjacencies within frames t and t + 1
+                        auto const first = graph.frameOfVertex(v) == t ? graph.adjacenciesInFrameBegin(v) : graph.adjacenciesToPreviousFrameBegin(v);
+                        auto const last = graph.frameOfVertex(v) == t ? graph.adjacenciesToNextFrameEnd(v) : graph.adjacenciesInFrameEnd(v);
+
+                        for (auto it = first; it != last; ++it)
                         {
-                            // check for chords
-                            std::fill(seen.begin(), seen.end(), 0);
-                            if (hasChord(data_.problemGraph.graph(), path.begin(), path.end(), seen, true))
+                            auto const w = it->vertex();
+
+                            if (labels_[it->edge()] > .5 || workspace.visited[w] == workspace.epoch)
                                 continue;
-                        }
 
-                        
-                        for (size_t j = 0; j < path.size() - 1; ++j)
-                        {
-                            variables_[j] = data_.problemGraph.graph().findEdge(path[j], path[j + 1]).second;
-                            coefficients_[j] = 1.0;
+                            workspace.visited[w] = workspace.epoch;
+                            components[w] = root;
+                            workspace.queue.push_back(w);
                         }
+                    }
+                }
+        }
 
-                        variables_[path.size() - 1] = e;
-                        coefficients_[path.size() - 1] = -1.0;
+        // Cycle constraints of the cut edges of frame t and of the cut edges from frame t to frame t + 1 whose
+        // vertices are connected in frames t and t + 1 without cut edges. The violated edges are grouped by
+        // their first vertex, and the paths closing the cycles of a group are taken from one breadth-first
+        // search tree rooted at that vertex. The paths are thus shortest paths, as those of spsp.
+        void separateCycleConstraints(size_t const t, Workspace& workspace)
+        {
+            auto const& graph = data_.problemGraph.graph();
+            auto& violated = workspace.violatedEdges;
+            violated.clear();
 
-                        this->addLazyConstraint(variables_.begin(), variables_.begin() + path.size(), coefficients_.begin(), 0, std::numeric_limits<double>::infinity());
+            for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(t); ++i)
+            {
+                auto const e = data_.problemGraph.edgeInFrame(t, i);
+                violated.emplace_back(graph.vertexOfEdge(e, 0), e);
+            }
 
-                        ++counter;
-                        
-                    }
+            if (t + 1 < data_.problemGraph.numberOfFrames())
+                for (size_t j = 0; j < data_.problemGraph.numberOfEdgesFromFrame(t); ++j)
+                {
+                    auto const e = data_.problemGraph.edgeFromFrame(t, j);
+                    violated.emplace_back(graph.vertexOfEdge(e, 0), e);
                 }
-            }
 
-            // separate cycles in the last frame
-            size_t t = data_.problemGraph.numberOfFrames() - 1;
-            for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(t); ++i)
+            // keep the edges that violate connectivity as defined by connected components
+            violated.erase(std::remove_if(violated.begin(), violated.end(), [&](std::pair<size_t, size_t> const& p)
             {
-                auto e = data_.problemGraph.edgeInFrame(t, i);
+                auto const v1 = graph.vertexOfEdge(p.second, 1);
+                return labels_[p.second] < .5 || workspace.components[p.first] != workspace.components[v1];
+            }), violated.end());
 
-                auto v0 = data_.problemGraph.graph().vertexOfEdge(e, 0);
-                auto v1 = data_.problemGraph.graph().vertexOfEdge(e, 1);
-                
-                // if an edge violates connectivity as defined by connected components
-                if (this->label(e) > .5 && componentsInFrame_.areConnected(v0, v1))
+            std::sort(violated.begin(), violated.end());
+
+            for (auto first = violated.begin(); first != violated.end(); )
+            {
+                auto const source = first->first;
+                auto last = first;
+                while (last != violated.end() && last->first == source)
+                    ++last;
+
+                workspace.targets.clear();
+                for (auto it = first; it != last; ++it)
+                    workspace.targets.push_back(graph.vertexOfEdge(it->second, 1));
+
+                growSearchTree(t, source, workspace);
+
+                for (; first != last; ++first)
                 {
-                    // find the shortest path using BFS
-                    spsp(
-                        data_.problemGraph.graph(),
-                        SubgraphWithoutCutAndInterFrameEdges(data_.problemGraph.problem(), EdgeLabels(*this)),
-                        v0, v1, path, buffer
-                    );
+                    auto const e = first->second;
+                    auto const v1 = graph.vertexOfEdge(e, 1);
+
+                    pathInSearchTree(source, v1, workspace);
 
                     // skip chord check for triangles
-                    if (path.size() > 3)
-                    {
-                        // check for chords
-                        std::fill(seen.begin(), seen.end(), 0);
-                        if (hasChord(data_.problemGraph.graph(), path.begin(), path.end(), seen, true))
-                            continue;
-                    }
-                    
-                    for (size_t j = 0; j < path.size() - 1; ++j)
-                    {
-                        variables_[j] = data_.problemGraph.graph().findEdge(path[j], path[j + 1]).second;
-                        coefficients_[j] = 1.0;
-                    }
+                    if (workspace.path.size() > 3 && hasChord(workspace))
+                        continue;
 
-                    variables_[path.size() - 1] = e;
-                    coefficients_[path.size() - 1] = -1.0;
+                    auto& constraints = cache_[t].constraints[graph.frameOfVertex(v1) == t ? SpaceCycle : SpacetimeCycle];
 
-                    this->addLazyConstraint(variables_.begin(), variables_.begin() + path.size(), coefficients_.begin(), 0, std::numeric_limits<double>::infinity());
+                    for (size_t j = 0; j < workspace.path.size() - 1; ++j)
+                        constraints.add(graph.findEdge(workspace.path[j], workspace.path[j + 1]).second, 1.0);
 
-                    ++counter;                    
+                    constraints.add(e, -1.0);
+                    constraints.close(0);
                 }
             }
-                
-
-            return counter;
         }
 
-        size_t separateAndAddSpacetimeCycleConstraints()
+        // breadth-first search in frames t and t + 1 without cut edges from source until all workspace.targets
+        // are reached
+        void growSearchTree(size_t const t, size_t const source, Workspace& workspace)
         {
-            std::deque<size_t> path;
-            std::vector<ptrdiff_t> buffer;
-            size_t counter = 0;
+            auto const& graph = data_.problemGraph.graph();
 
-            std::vector<char> seen(data_.problemGraph.graph().numberOfVertices());
-            std::vector<ptrdiff_t> parent(data_.problemGraph.graph().numberOfVertices());
-            std::vector<double> cost(data_.problemGraph.graph().numberOfVertices());
-            std::vector<size_t> dist(data_.problemGraph.graph().numberOfVertices());
+            ++workspace.epoch;
 
-            for (size_t t = 0; t < data_.problemGraph.numberOfFrames() - 1; ++t)
+            size_t remaining = 0;
+            for (auto const v : workspace.targets)
             {
-                // do connected components labeling only for frames t and t+1
-                ComponentsType components;
-                components.build(
-                    data_.problemGraph.graph(),
-                    SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t)
-                );
+                workspace.marked[v] = workspace.epoch;
+                ++remaining;
+            }
 
-                for (size_t j = 0; j < data_.problemGraph.numberOfEdgesFromFrame(t); ++j)
+            workspace.visited[source] = workspace.epoch;
+            workspace.parent[source] = source;
+            workspace.queue.assign(1, source);
+
+            for (size_t head = 0; remaining > 0 && head < workspace.queue.size(); ++head)
+            {
+                auto const v = workspace.queue[head];
+
+                // adjacencies within frames t and t + 1
+                auto const begin = graph.frameOfVertex(v) == t ? graph.adjacenciesInFrameBegin(v) : graph.adjacenciesToPreviousFrameBegin(v);
+                auto const end = graph.frameOfVertex(v) == t ? graph.adjacenciesToNextFrameEnd(v) : graph.adjacenciesInFrameEnd(v);
+
+                for (auto it = begin; it != end; ++it)
                 {
-                    auto e = data_.problemGraph.edgeFromFrame(t, j);
-                    auto v0 = data_.problemGraph.graph().vertexOfEdge(e, 0);
-                    auto v1 = data_.problemGraph.graph().vertexOfEdge(e, 1);
+                    auto const w = it->vertex();
 
-                    // if a time edge violates connectivity
-                    if (this->label(e) > .5 && components.areConnected(v0, v1))
-                    {
-                        // find the shortest path using BFS
-                        spsp(
-                            data_.problemGraph.graph(),
-                            SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t),
-                            v0, v1, path, buffer
-                        );
-
-                        // skip chord check for triangles
-                        if (path.size() > 3)
-                        {
-                            // check for chords
-                            std::fill(seen.begin(), seen.end(), 0);
-                            if (hasChord(data_.problemGraph.graph(), path.begin(), path.end(), seen, true))
-                                continue;
-                        }
+                    if (labels_[it->edge()] > .5 || workspace.visited[w] == workspace.epoch)
+                        continue;
 
-                        for (size_t k = 0; k < path.size() - 1; ++k)
-                        {
-                            variables_[k] = data_.problemGraph.graph().findEdge(path[k], path[k + 1]).second;
-                            coefficients_[k] = 1.0;
-                        }
+                    workspace.visited[w] = workspace.epoch;
+                    workspace.parent[w] = v;
+                    workspace.queue.push_back(w);
+
+                    if (workspace.marked[w] == workspace.epoch)
+                        --remaining;
+                }
+            }
+        }
 
-                        variables_[path.size() - 1] = e;
-                        coefficients_[path.size() - 1] = -1.0;
+        // path from the root of the last search tree to v
+        void pathInSearchTree(size_t const root, size_t const v, Workspace& workspace)
+        {
+            workspace.path.clear();
+            for (auto w = v; w != root; w = workspace.parent[w])
+                workspace.path.push_front(w);
+            workspace.path.push_front(root);
+        }
 
-                        this->addLazyConstraint(variables_.begin(), variables_.begin() + path.size(), coefficients_.begin(), 0, std::numeric_limits<double>::infinity());
+        // whether the cycle of workspace.path, closed by an edge between its first and its last vertex, has a
+        // chord, cf. andres::graph::hasChord
+        bool hasChord(Workspace& workspace)
+        {
+            auto const& graph = data_.problemGraph.graph();
+            auto const& path = workspace.path;
 
-                        ++counter;
-                    }
+            ++workspace.epoch;
+            for (size_t j = 0; j < path.size(); ++j)
+            {
+                if (workspace.seen[path[j]] == workspace.epoch)
+                    return true;
+
+                for (auto it = graph.adjacenciesFromVertexBegin(path[j]); it != graph.adjacenciesFromVertexEnd(path[j]); ++it)
+                {
+                    // exclude the edge between the first and the last vertex, and the next edge of the path
+                    if (j == 0 && it->vertex() == path.back())
+                        continue;
+
+                    if (j + 1 < path.size() && it->vertex() == path[j + 1])
+                        continue;
+
+                    workspace.seen[it->vertex()] = workspace.epoch;
                 }
             }
 
-            return counter;
+            return false;
         }
 
-        size_t separateAndAddMoralityConstraints()
+        // Morality constraints of frame t, for the pairs of vertices of frame t that are connected in frames t and
+        // t + 1 without cut edges but not in frame t. Pairs whose shortest path has an inner vertex in frame t
+        // admit a "lifted" chord and are skipped. All other pairs have uncut edges to a common component of frame
+        // t + 1, so the pairs are enumerated by these successor components instead of over all pairs of frame t.
+        void separateMoralityConstraints(size_t const t, Workspace& workspace)
         {
-            std::deque<size_t> path;
-            std::vector<ptrdiff_t> buffer;
-            std::vector<char> visited(data_.problemGraph.graph().numberOfVertices());
-            size_t counter = 0;
+            auto const& graph = data_.problemGraph.graph();
+            auto const& components = componentsInFrame_.labels_;
+            auto& constraints = cache_[t].constraints[Morality];
+            auto const& path = workspace.path;
 
-            std::vector<char> seen(data_.problemGraph.graph().numberOfVertices());
-            std::vector<ptrdiff_t> parent(data_.problemGraph.graph().numberOfVertices());
-            std::vector<double> cost(data_.problemGraph.graph().numberOfVertices());
-            std::vector<size_t> dist(data_.problemGraph.graph().numberOfVertices());
+            // vertices of frame t by successor component
+            auto& successors = workspace.successors;
+            successors.clear();
 
-            for (size_t t = 0; t < data_.problemGraph.numberOfFrames() - 1; ++t)
+            for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
             {
-                // do connected components labeling only for frames t and t+1
-                ComponentsType components;
-                components.build(
-                    data_.problemGraph.graph(),
-                    SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t)
-                );
-
-                // iterate over all node pairs
-                for (size_t i = 0; i < data_.problemGraph.numberOfNodesInFrame(t); ++i)
-                    for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
-                    {
-                        if (i == j)
-                            continue;
+                auto const v = data_.problemGraph.nodeInFrame(t, j);
+                for (auto it = graph.adjacenciesToNextFrameBegin(v); it != graph.adjacenciesToNextFrameEnd(v); ++it)
+                    if (labels_[it->edge()] < .5)
+                        successors.emplace_back(components[it->vertex()], v);
+            }
 
-                        auto v0 = data_.problemGraph.nodeInFrame(t, i);
-                        auto v1 = data_.problemGraph.nodeInFrame(t, j);
+            std::sort(successors.begin(), successors.end());
+            successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
 
-                        // skip pairs which correspond to an edge
-                        if (data_.problemGraph.graph().findEdge(v0,v1).first)
-                            continue;
+            // ordered pairs in distinct components of frame t with a common successor component
+            auto& pairs = workspace.pairs;
+            pairs.clear();
 
-                        if (components.areConnected(v0, v1) && !componentsInFrame_.areConnected(v0, v1))
-                        {
-                            // find the shortest path using BFS
-                            spsp(
-                                data_.problemGraph.graph(),
-                                SubgraphOfTwoFramesWithoutCut(data_.problemGraph.problem(), EdgeLabels(*this), t),
-                                v0, v1, path, buffer
-                            );
-
-                            // skip chord check for triangles
-                            if (path.size() > 3)
-                            {
-                                // skip paths that admit a "lifted" chord
-                                bool f_chord = false;
-                                for (auto it = path.begin() + 1; it != path.end() - 1 && !f_chord; it++)
-                                {
-                                    if (data_.problemGraph.frameOfNode(*it) == t)
-                                    {
-                                        f_chord = true;
-                                        break;
-                                    }
-                                }
+            for (auto first = successors.begin(); first != successors.end(); )
+            {
+                auto last = first;
+                while (last != successors.end() && last->first == first->first)
+                    ++last;
 
-                                if (f_chord)
-                                    continue;
+                for (auto a = first; a != last; ++a)
+                    for (auto b = first; b != last; ++b)
+                        if (components[a->second] != components[b->second])
+                            pairs.emplace_back(a->second, b->second);
 
-                                // check for chords
-                                std::fill(seen.begin(), seen.end(), 0);
-                                if (hasChord(data_.problemGraph.graph(), path.begin(), path.end(), seen, true))
-                                    continue;
-                            }
+                first = last;
+            }
 
-                            // store variables
-                            ptrdiff_t sz = 0;
-                            for (size_t k = 0; k < path.size() - 1; ++k)
-                            {
-                                coefficients_[sz] = 1.0;
-                                variables_[sz] = data_.problemGraph.graph().findEdge(path[k], path[k + 1]).second;
-                                ++sz;
-                            }
+            std::sort(pairs.begin(), pairs.end());
+            pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+            for (auto first = pairs.begin(); first != pairs.end(); )
+            {
+                auto const v0 = first->first;
+                auto last = first;
+                while (last != pairs.end() && last->first == v0)
+                    ++last;
+
+                // skip pairs which correspond to an edge
+                workspace.targets.clear();
+                for (auto it = first; it != last; ++it)
+                    if (!graph.findEdge(v0, it->second).first)
+                        workspace.targets.push_back(it->second);
+
+                first = last;
+
+                if (workspace.targets.empty())
+                    continue;
 
-                            // find a cut that separates v0 and v1 in frame t using DFS
-                            std::fill(visited.begin() + data_.problemGraph.nodeInFrame(t, 0), visited.begin() + data_.problemGraph.nodeInFrame(t + 1, 0), 0);
+                growSearchTree(t, v0, workspace);
 
-                            std::stack<size_t> stack;
-                            stack.push(v0);
-                            visited[v0] = 1;
-                            
-                            while (!stack.empty())
+                // the cut that separates the component of v0 from the rest of frame t is shared by all pairs of v0
+                auto& cut = workspace.cut;
+                cut.clear();
+                ++workspace.epoch;
+
+                workspace.queue.assign(1, v0);
+                workspace.visited[v0] = workspace.epoch;
+
+                while (!workspace.queue.empty())
+                {
+                    auto v = workspace.queue.back();
+                    workspace.queue.pop_back();
+
+                    for (auto it = graph.adjacenciesInFrameBegin(v); it != graph.adjacenciesInFrameEnd(v); ++it)
+                    {
+                        auto w = it->vertex();
+
+                        if (components[v] != components[w])
+                            cut.push_back(it->edge());
+                        else if (workspace.visited[w] != workspace.epoch)
+                        {
+                            workspace.visited[w] = workspace.epoch;
+                            workspace.queue.push_back(w);
+                        }
+                    }
+                }
+
+                for (auto const v1 : workspace.targets)
+                {
+                    pathInSearchTree(v0, v1, workspace);
+
+                    // skip chord check for triangles
+                    if (path.size() > 3)
+                    {
+                        // skip paths that admit a "lifted" chord
+                        bool f_chord = false;
+                        for (auto it = path.begin() + 1; it != path.end() - 1; it++)
+                            if (data_.problemGraph.frameOfNode(*it) == t)
                             {
-                                auto v = stack.top();
-                                stack.pop();
-
-                                for (auto it2 = data_.problemGraph.graph().adjacenciesFromVertexBegin(v); it2 != data_.problemGraph.graph().adjacenciesFromVertexEnd(v); ++it2)
-                                {
-                                    auto w = it2->vertex();
-                                    
-                                    if (data_.problemGraph.frameOfNode(v) == data_.problemGraph.frameOfNode(w))
-                                    {
-                                        if (componentsInFrame_.labels_[v] != componentsInFrame_.labels_[w])
-                                        {
-                                            coefficients_[sz] = -1.0;
-                                            variables_[sz] = it2->edge();
-                                            
-                                            ++sz;
-                                        }
-                                        else if (!visited[w])
-                                        {
-                                            visited[w] = 1;
-                                            stack.push(w);
-                                        }
-                                    }
-                                }
+                                f_chord = true;
+                                break;
                             }
-                            
-                            this->addLazyConstraint(variables_.begin(), variables_.begin() + sz, coefficients_.begin(), 1 - (sz - static_cast<ptrdiff_t>(path.size()) + 1), std::numeric_limits<double>::infinity());
 
-                            ++counter;  
-                        }
+                        if (f_chord)
+                            continue;
+
+                        // check for chords
+                        if (hasChord(workspace))
+                            continue;
                     }
-            }
 
-            return counter;
+                    for (size_t k = 0; k < path.size() - 1; ++k)
+                        constraints.add(graph.findEdge(path[k], path[k + 1]).second, 1.0);
+
+                    for (auto const e : cut)
+                        constraints.add(e, -1.0);
+
+                    constraints.close(1 - static_cast<ptrdiff_t>(cut.size()));
+                }
+            }
         }
 
-        size_t separateAndAddTerminationConstraints()
-        {           
-            size_t counter = 0;
+        void separateTerminationConstraints(size_t const t, Workspace& workspace)
+        {
+            auto& constraints = cache_[t].constraints[Termination];
 
-            for (size_t t = 0; t < data_.problemGraph.numberOfFrames() - 1; ++t)
-                for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
-                {
-                    auto v = data_.problemGraph.nodeInFrame(t, j);
-                    auto terminationVariableIndex = v + data_.problemGraph.graph().numberOfEdges();
+            for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+            {
+                auto v = data_.problemGraph.nodeInFrame(t, j);
+                auto terminationVariableIndex = v + data_.problemGraph.graph().numberOfEdges();
 
-                    // check whether the connected component in frame t is terminated or not
-                    if (this->label(terminationVariableIndex) < .5)
-                    {
-                        std::vector<char> successor(data_.problemGraph.graph().numberOfVertices());
+                // check whether the connected component in frame t is terminated or not
+                if (labels_[terminationVariableIndex] < .5)
+                {
+                    // visited and successors of v
+                    ++workspace.epoch;
 
-                        std::vector<char> visited(data_.problemGraph.graph().numberOfVertices());
+                    ptrdiff_t sz = 0;
+                    workspace.queue.assign(1, v);
+                    size_t head = 0;
 
-                        ptrdiff_t sz = 0;
-                        std::queue<size_t> queue;
-                        queue.push(v);
+                    workspace.visited[v] = workspace.epoch;
 
-                        visited[v] = 1;
+                    bool terminated = true;
 
-                        bool terminated = true;
+                    // do the check and find the reduced cut at the same time
+                    while (head < workspace.queue.size() && terminated)
+                    {
+                        auto vv = workspace.queue[head++];
 
-                        // do the check and find the reduced cut at the same time
-                        while (!queue.empty() && terminated)
+                        for (auto it = data_.problemGraph.graph().adjacenciesInFrameBegin(vv);
+                            it != data_.problemGraph.graph().adjacenciesToNextFrameEnd(vv); ++it)
                         {
-                            auto vv = queue.front();
-                            queue.pop();
+                            auto w = it->vertex();
+                            auto e = it->edge();
 
-                            for (auto it = data_.problemGraph.graph().adjacenciesFromVertexBegin(vv);
-                                it != data_.problemGraph.graph().adjacenciesFromVertexEnd(vv); ++it)
+                            // fragment is not terminated
+                            if (data_.problemGraph.frameOfNode(w) == t + 1 && labels_[e] < .5)
                             {
-                                auto w = it->vertex();
-                                auto e = it->edge();
-
-                                if (data_.problemGraph.frameOfNode(w) < t)
-                                    continue;
-
-                                // fragment is not terminated
-                                if (data_.problemGraph.frameOfNode(w) == t + 1 && this->label(e) < .5)
-                                {
-                                    terminated = false;
-                                    break;
-                                }
-
-                                if (data_.problemGraph.frameOfNode(w) == t && !visited[w] && this->label(e) < .5)
-                                {
-                                    visited[w] = 1;
-                                    queue.push(w);
-                                }
-
-                                // add edge to the cut if it is not incident to a successor of v
-                                if (this->label(e) > .5 && !successor[w])
-                                {
-                                    coefficients_[sz] = -1.0;
-                                    variables_[sz] = e;
-                                    
-                                    ++sz;
-
-                                    if (vv == v && data_.problemGraph.frameOfNode(w) == t + 1)
-                                        successor[w] = 1;
-                                }
+                                terminated = false;
+                                break;
                             }
-                        }
 
-                        if (terminated)
+                            if (data_.problemGraph.frameOfNode(w) == t && workspace.visited[w] != workspace.epoch && labels_[e] < .5)
                             {
-                                coefficients_[sz] = 1.0;
-                                variables_[sz] = v + data_.problemGraph.graph().numberOfEdges();
+                                workspace.visited[w] = workspace.epoch;
+                                workspace.queue.push_back(w);
+                            }
 
-                                // sz = cut capacity
-                                this->addLazyConstraint(variables_.begin(), variables_.begin() + sz + 1, coefficients_.begin(), 1 - sz, std::numeric_limits<double>::infinity());
+                            // add edge to the cut if it is not incident to a successor of v
+                            if (labels_[e] > .5 && workspace.marked[w] != workspace.epoch)
+                            {
+                                constraints.add(e, -1.0);
+                                ++sz;
 
-                                ++counter;
+                                if (vv == v && data_.problemGraph.frameOfNode(w) == t + 1)
+                                    workspace.marked[w] = workspace.epoch;
                             }
+                        }
                     }
-                }
 
-            return counter;
+                    if (terminated)
+                    {
+                        constraints.add(terminationVariableIndex, 1.0);
+
+                        // sz = cut capacity
+                        constraints.close(1 - sz);
+                    }
+                    else
+                        constraints.discard();
+                }
+            }
         }
 
-        size_t separateAndAddBirthConstraints()
+        void separateBirthConstraints(size_t const t, Workspace& workspace)
         {
+            auto& constraints = cache_[t].constraints[Birth];
+
             auto offset = data_.problemGraph.graph().numberOfEdges();
             if (data_.costTermination > .0)
                 offset += data_.problemGraph.graph().numberOfVertices();
 
-            size_t counter = 0;
-            
-            for (size_t t = 1; t < data_.problemGraph.numberOfFrames(); ++t)
-                for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+            for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+            {
+                auto v = data_.problemGraph.nodeInFrame(t, j);
+                auto birthVariableIndex = v + offset;
+
+                if (labels_[birthVariableIndex] < .5)
                 {
-                    auto v = data_.problemGraph.nodeInFrame(t, j);
-                    auto birthVariableIndex = v + offset;
+                    // visited and predecessors of v
+                    ++workspace.epoch;
 
-                    if (this->label(birthVariableIndex) < .5)
-                    {
-                        std::vector<char> predecessor(data_.problemGraph.graph().numberOfVertices());
+                    ptrdiff_t sz = 0;
+                    workspace.queue.assign(1, v);
+                    size_t head = 0;
+                    
+                    workspace.visited[v] = workspace.epoch;
+                    
+                    bool born = true;
 
-                        std::vector<char> visited(data_.problemGraph.graph().numberOfVertices());
-                        
-                        ptrdiff_t sz = 0;
-                        std::queue<size_t> queue;
-                        queue.push(v);
-                        
-                        visited[v] = 1;
+                    while (head < workspace.queue.size() && born)
+                    {
+                        auto vv = workspace.queue[head++];
                         
-                        bool born = true;
-
-                        while (!queue.empty() && born)
+                        for (auto it = data_.problemGraph.graph().adjacenciesToPreviousFrameBegin(vv);
+                            it != data_.problemGraph.graph().adjacenciesInFrameEnd(vv); ++it)
                         {
-                            auto vv = queue.front();
-                            queue.pop();
-                            
-                            for (auto it = data_.problemGraph.graph().adjacenciesFromVertexBegin(vv);
-                                it != data_.problemGraph.graph().adjacenciesFromVertexEnd(vv); ++it)
+                            auto w = it->vertex();
+                            auto e = it->edge();
+
+                            // fragment is not born
+                            if (data_.problemGraph.frameOfNode(w) == t - 1 && labels_[e] < .5)
                             {
-                                auto w = it->vertex();
-                                auto e = it->edge();
-
-                                if (data_.problemGraph.frameOfNode(w) > t)
-                                    continue;
-
-                                // fragment is not born
-                                if (data_.problemGraph.frameOfNode(w) == t - 1 && this->label(e) < .5)
-                                {
-                                    born = false;
-                                    break;
-                                }
-
-                                if (data_.problemGraph.frameOfNode(w) == t && !visited[w] && this->label(e) < .5)
-                                {
-                                    visited[w] = 1;
-                                    queue.push(w);
-                                }
-
-                                // add edge to the cut if it is not incident to a predecessor of v
-                                if (this->label(e) > .5 && !predecessor[w])
-                                {
-                                    coefficients_[sz] = -1.0;
-                                    variables_[sz] = e;
-                                    
-                                    ++sz;
-
-                                    if (vv == v && data_.problemGraph.frameOfNode(w) == t - 1)
-                                        predecessor[w] = 1;
-                                }
+                                born = false;
+                                break;
                             }
-                        }
 
-                        if (born)
+                            if (data_.problemGraph.frameOfNode(w) == t && workspace.visited[w] != workspace.epoch && labels_[e] < .5)
                             {
-                                variables_[sz] = v + offset;
-                                coefficients_[sz] = 1.0;
+                                workspace.visited[w] = workspace.epoch;
+                                workspace.queue.push_back(w);
+                            }
 
-                                // sz = cut capacity
-                                this->addLazyConstraint(variables_.begin(), variables_.begin() + sz + 1, coefficients_.begin(), 1 - sz, std::numeric_limits<double>::infinity());
+                            // add edge to the cut if it is not incident to a predecessor of v
+                            if (labels_[e] > .5 && workspace.marked[w] != workspace.epoch)
+                            {
+                                constraints.add(e, -1.0);
+                                ++sz;
 
-                                ++counter;
+                                if (vv == v && data_.problemGraph.frameOfNode(w) == t - 1)
+                                    workspace.marked[w] = workspace.epoch;
                             }
+                        }
                     }
-                }
 
-            return counter;
+                    if (born)
+                    {
+                        constraints.add(birthVariableIndex, 1.0);
+
+                        // sz = cut capacity
+                        constraints.close(1 - sz);
+                    }
+                    else
+                        constraints.discard();
+                }
+            }
         }
 
-        size_t separateAndAddBifurcationConstraints()
+        // for each connected component, the sorted cut that separates it from all other components
+        void findComponentCuts()
         {
-            std::deque<size_t> path;
-            std::vector<ptrdiff_t> buffer;
-            
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            
-            std::vector<ptrdiff_t> parent(data_.problemGraph.graph().numberOfVertices(), -1);
-            size_t counter = 0;
+            parent_.assign(data_.problemGraph.graph().numberOfVertices(), -1);
 
-            // for each connected component find the cut that separates it from all other components
-            std::vector<std::vector<size_t>> cuts(*max_element(componentsInFrame_.labels_.begin(), componentsInFrame_.labels_.end()) + 1);
+            cuts_.resize(*max_element(componentsInFrame_.labels_.begin(), componentsInFrame_.labels_.end()) + 1);
+            for (auto& c : cuts_)
+                c.clear();
 
             for (size_t t = 0; t < data_.problemGraph.numberOfFrames(); ++t)
                 for (size_t i = 0; i < data_.problemGraph.numberOfEdgesInFrame(t); ++i)
@@ -773,118 +1000,314 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
                     auto v0 = data_.problemGraph.graph().vertexOfEdge(e, 0);
                     auto v1 = data_.problemGraph.graph().vertexOfEdge(e, 1);
                     
-                    if (this->label(e) > .5)
+                    if (labels_[e] > .5)
                     {
-                        cuts[componentsInFrame_.labels_[v0]].push_back(e);
-                        cuts[componentsInFrame_.labels_[v1]].push_back(e);
+                        cuts_[componentsInFrame_.labels_[v0]].push_back(e);
+                        cuts_[componentsInFrame_.labels_[v1]].push_back(e);
                     }
                 }
 
-            for (auto& c : cuts)
+            for (auto& c : cuts_)
                 sort(c.begin(), c.end());
-            
-            //////////////////////////////////////////////////////////////////////////////////////////////////
-            
+        }
 
-            for (size_t t = 0; t < data_.problemGraph.numberOfFrames() - 1; ++t)
-                for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+        void separateBifurcationConstraints(size_t const t, Workspace& workspace)
+        {
+            auto& constraints = cache_[t].constraints[Bifurcation];
+
+            for (size_t j = 0; j < data_.problemGraph.numberOfNodesInFrame(t); ++j)
+            {
+                auto v = data_.problemGraph.nodeInFrame(t, j);
+
+                // if not visited
+                if (parent_[v] == -1)
                 {
-                    auto v = data_.problemGraph.nodeInFrame(t, j);
+                    // map from frame component labels to vertex/edge pairs that correspond to the touch points
+                    std::map<size_t, std::pair<size_t, size_t>> touch_points;
 
-                    // if not visited
-                    if (parent[v] == -1)
+                    workspace.queue.assign(1, v);
+                    size_t head = 0;
+                    
+                    parent_[v] = v;
+                    
+                    while (head < workspace.queue.size())
                     {
-                        // map from frame component labels to vertex/edge pairs that correspond to the touch points
-                        std::map<size_t, std::pair<size_t, size_t>> touch_points;
-
-                        std::queue<size_t> Q;
-                        Q.push(v);
-                        
-                        parent[v] = v;
+                        auto vv = workspace.queue[head++];
                         
-                        while (!Q.empty())
+                        for (auto it = data_.problemGraph.graph().adjacenciesInFrameBegin(vv); it != data_.problemGraph.graph().adjacenciesToNextFrameEnd(vv); ++it)
                         {
-                            auto vv = Q.front();
-                            Q.pop();
-                            
-                            for (auto it = data_.problemGraph.graph().adjacenciesFromVertexBegin(vv); it != data_.problemGraph.graph().adjacenciesFromVertexEnd(vv); ++it)
-                            {
-                                auto w = it->vertex();
-                                auto e = it->edge();
+                            auto w = it->vertex();
+                            auto e = it->edge();
 
-                                if (data_.problemGraph.frameOfNode(w) == t + 1 && this->label(e) < .5 && touch_points.count(componentsInFrame_.labels_[w]) == 0)
-                                    touch_points[componentsInFrame_.labels_[w]] = std::make_pair(vv, e);
+                            if (data_.problemGraph.frameOfNode(w) == t + 1 && labels_[e] < .5 && touch_points.count(componentsInFrame_.labels_[w]) == 0)
+                                touch_points[componentsInFrame_.labels_[w]] = std::make_pair(vv, e);
 
-                                if (data_.problemGraph.frameOfNode(w) == t && parent[w] == -1 && this->label(e) < .5)
-                                {
-                                    parent[w] = vv;
-                                    Q.push(w);
-                                }
+                            if (data_.problemGraph.frameOfNode(w) == t && parent_[w] == -1 && labels_[e] < .5)
+                            {
+                                parent_[w] = vv;
+                                workspace.queue.push_back(w);
                             }
                         }
+                    }
 
-                        // if there are more than 2 components in the next frame
-                        if (touch_points.size() > 2)
-                        {
-                            std::vector<size_t> P;
-                            std::vector<size_t> C;
+                    // if there are more than 2 components in the next frame
+                    if (touch_points.size() > 2)
+                    {
+                        std::vector<size_t> P;
+                        std::vector<size_t> C;
 
-                            for (auto& p : touch_points)
+                        for (auto& p : touch_points)
+                        {
+                            auto w = p.second.first;
+                            while (w != v)
                             {
-                                auto w = p.second.first;
-                                while (w != v)
-                                {
-                                    P.push_back(data_.problemGraph.graph().findEdge(parent[w], w).second);
-                                    w = parent[w];
-                                }
+                                P.push_back(data_.problemGraph.graph().findEdge(parent_[w], w).second);
+                                w = parent_[w];
+                            }
 
-                                P.push_back(p.second.second);
+                            P.push_back(p.second.second);
 
-                                C.insert(C.end(), cuts[p.first].begin(), cuts[p.first].end());
-                            }
+                            C.insert(C.end(), cuts_[p.first].begin(), cuts_[p.first].end());
+                        }
 
-                            std::sort(P.begin(), P.end());
-                            std::sort(C.begin(), C.end());
+                        std::sort(P.begin(), P.end());
+                        std::sort(C.begin(), C.end());
 
-                            P.erase(std::unique(P.begin(), P.end()), P.end());
-                            C.erase(std::unique(C.begin(), C.end()), C.end());
+                        P.erase(std::unique(P.begin(), P.end()), P.end());
+                        C.erase(std::unique(C.begin(), C.end()), C.end());
 
-                            ptrdiff_t sz = 0;
-                            for (auto e : P)
-                            {
-                                coefficients_[sz] = 1.0;
-                                variables_[sz] = e;
-                                
-                                ++sz;
-                            }
+                        for (auto e : P)
+                            constraints.add(e, 1.0);
 
-                            for (auto e : C)
-                            {
-                                coefficients_[sz] = -1.0;
-                                variables_[sz] = e;
+                        for (auto e : C)
+                            constraints.add(e, -1.0);
 
-                                ++sz;
-                            }
+                        constraints.close(1 - static_cast<ptrdiff_t>(C.size()));
+                    }
+                }
+            }
+        }
+
+        // Bring partitionGraph_ up to date with edgeLabels_ and set its branching labels. The graph is kept
+        // between calls. Only frames whose in-frame labels changed are relabeled, and only the branchings
+        // of the pairs of frames whose partitions changed are solved again.
+        void updatePartitionGraph()
+        {
+            auto const numberOfFrames = data_.problemGraph.numberOfFrames();
+            auto const numberOfSteps = numberOfFrames > 0 ? numberOfFrames - 1 : 0;
 
-                            this->addLazyConstraint(variables_.begin(), variables_.begin() + sz, coefficients_.begin(), 1 - static_cast<ptrdiff_t>(C.size()), std::numeric_limits<double>::infinity());
+            std::vector<size_t> steps; // pairs of frames t, t + 1 to solve, by t
+            if (!partitionGraph_)
+            {
+                partitionGraph_.reset(new lineage::heuristics::PartitionGraph(data_, edgeLabels_));
 
-                            ++counter;
-                        }
+                partitionsInFrame_.assign(numberOfFrames, {});
+                for (size_t p = 0; p < partitionGraph_->partitions_.size(); ++p)
+                    partitionsInFrame_[partitionGraph_->frameOfPartition(p)].push_back(p);
+
+                branching_.resize(numberOfSteps);
+                for (size_t t = 0; t < numberOfSteps; ++t)
+                    steps.push_back(t);
+
+                std::fill(changedFrames_.begin(), changedFrames_.end(), false);
+            }
+            else
+            {
+                for (size_t t = 0; t < numberOfFrames; ++t)
+                {
+                    if (!changedFrames_[t])
+                        continue;
+                    changedFrames_[t] = false;
+
+                    if (relabelFrame(t))
+                    {
+                        if (t > 0)
+                            steps.push_back(t - 1);
+                        if (t < numberOfSteps)
+                            steps.push_back(t);
                     }
                 }
+                steps.erase(std::unique(steps.begin(), steps.end()), steps.end());
+            }
 
-            return counter;
+            data_.threadPool->parallelFor(steps.size(), [&](size_t i) {
+                solveStep(steps[i]);
+            });
+
+            auto& pgraph = *partitionGraph_;
+            pgraph.branchingLabels_.assign(pgraph.numberOfEdges(), false);
+            for (auto const& step : branching_)
+                for (auto const& pair : step)
+                    pgraph.branchingLabels_[pgraph.findEdge(pair.first, pair.second).second] = true;
+        }
+
+        // Move the nodes of frame t to the components of frame t by edgeLabels_. A component keeps the
+        // partition of its first node if no other component took it. Returns false if no node moved.
+        bool relabelFrame(const size_t t)
+        {
+            auto& pgraph = *partitionGraph_;
+            auto const& graph = data_.problemGraph.graph();
+            auto const numberOfNodes = data_.problemGraph.numberOfNodesInFrame(t);
+            auto const none = std::numeric_limits<size_t>::max();
+
+            // components of frame t without cut edges
+            auto& component = relabeling_.component;
+            auto& roots = relabeling_.roots;
+            auto& queue = relabeling_.queue;
+            component.resize(graph.numberOfVertices());
+            roots.clear();
+
+            for (size_t j = 0; j < numberOfNodes; ++j)
+                component[data_.problemGraph.nodeInFrame(t, j)] = none;
+
+            for (size_t j = 0; j < numberOfNodes; ++j)
+            {
+                auto const root = data_.problemGraph.nodeInFrame(t, j);
+                if (component[root] != none)
+                    continue;
+
+                component[root] = roots.size();
+                queue.assign(1, root);
+                for (size_t head = 0; head < queue.size(); ++head)
+                {
+                    auto const v = queue[head];
+                    for (auto it = graph.adjacenciesInFrameBegin(v); it != graph.adjacenciesInFrameEnd(v); ++it)
+                        if (edgeLabels_[it->edge()] < .5 && component[it->vertex()] == none)
+                        {
+                            component[it->vertex()] = roots.size();
+                            queue.push_back(it->vertex());
+                        }
+                }
+
+                roots.push_back(root);
+            }
+
+            // partitions of the components
+            auto& previous = partitionsInFrame_[t];
+            auto& claimed = relabeling_.claimed;
+            auto& partitionOfComponent = relabeling_.partitionOfComponent;
+            claimed.assign(previous.size(), false);
+            partitionOfComponent.assign(roots.size(), none);
+
+            for (size_t k = 0; k < roots.size(); ++k)
+            {
+                auto const i = std::lower_bound(previous.begin(), previous.end(), pgraph.vertexLabels_[roots[k]]) - previous.begin();
+                if (!claimed[i])
+                {
+                    claimed[i] = true;
+                    partitionOfComponent[k] = previous[i];
+                }
+            }
+
+            size_t unclaimed = 0;
+            for (size_t k = 0; k < roots.size(); ++k)
+            {
+                if (partitionOfComponent[k] != none)
+                    continue;
+
+                while (unclaimed < previous.size() && claimed[unclaimed])
+                    ++unclaimed;
+
+                if (unclaimed < previous.size())
+                {
+                    claimed[unclaimed] = true;
+                    partitionOfComponent[k] = previous[unclaimed];
+                }
+                else if (!freePartitions_.empty())
+                {
+                    partitionOfComponent[k] = freePartitions_.back();
+                    freePartitions_.pop_back();
+                }
+                else
+                {
+                    pgraph.addVertex();
+                    partitionOfComponent[k] = pgraph.partitions_.size() - 1;
+                }
+            }
+
+            // move the nodes and update the edges of the partitions they leave and enter
+            auto& touched = relabeling_.touched;
+            touched.clear();
+            for (size_t j = 0; j < numberOfNodes; ++j)
+            {
+                auto const v = data_.problemGraph.nodeInFrame(t, j);
+                auto const target = partitionOfComponent[component[v]];
+                if (pgraph.vertexLabels_[v] == target)
+                    continue;
+
+                touched.push_back(pgraph.vertexLabels_[v]);
+                touched.push_back(target);
+                pgraph.forceMove(v, target);
+            }
+
+            if (touched.empty())
+                return false;
+
+            std::sort(touched.begin(), touched.end());
+            touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+            for (auto p : touched)
+                pgraph.updateEdgesOfPartition(p);
+
+            for (size_t i = 0; i < previous.size(); ++i)
+                if (!claimed[i])
+                    freePartitions_.push_back(previous[i]);
+
+            previous = partitionOfComponent;
+            std::sort(previous.begin(), previous.end());
+
+            return true;
+        }
+
+        // optimal branching between the partitions of frames t and t + 1, cf. HungarianBranching
+        void solveStep(const size_t t)
+        {
+            auto const& pgraph = *partitionGraph_;
+            auto const& first = partitionsInFrame_[t];
+
+            lineage::heuristics::SparseAssignment assignment;
+            std::vector<size_t> branchingEdges;
+            lineage::heuristics::branching::buildStepAssignment(pgraph, first, partitionsInFrame_[t + 1], assignment, branchingEdges);
+            assignment.solve();
+
+            branching_[t].clear();
+            for (size_t row = 0; row < 2 * first.size(); ++row)
+            {
+                auto const edge = branchingEdges[assignment.edgeOfRow(row)];
+                if (edge != lineage::heuristics::SparseAssignment::none())
+                    branching_[t].emplace_back(pgraph.vertexOfEdge(edge, 0), pgraph.vertexOfEdge(edge, 1));
+            }
         }
 
-        std::vector<double> coefficients_;
-        ComponentsType components_;
         ComponentsType componentsInFrame_;
         Data& data_;
         size_t numberOfFeasibleSolutions_ { 0 };
         size_t numberOfSeparationCalls_ { 0 };
-        std::vector<size_t> variables_;
+
+        std::vector<double> labels_; // of the solution being separated, by variable
+        std::vector<Workspace> workspaces_; // by block of frames
+        std::vector<FrameCache> cache_; // by frame
+        bool addCachedConstraints_ { false };
+        size_t numberOfCacheHits_ { 0 };
+        std::vector<std::vector<size_t>> cuts_; // by component of componentsInFrame_
+        std::vector<ptrdiff_t> parent_; // by vertex, of the bifurcation search
 
         std::vector<double> edgeLabels_;
+
+        // feasible solution
+        std::unique_ptr<lineage::heuristics::PartitionGraph> partitionGraph_; // of edgeLabels_, kept between calls
+        std::vector<bool> changedFrames_; // by frame, in-frame labels of edgeLabels_ not yet in partitionGraph_
+        std::vector<std::vector<size_t>> partitionsInFrame_; // by frame, sorted
+        std::vector<std::vector<std::pair<size_t, size_t>>> branching_; // parent and child partitions, by pair of frames t, t + 1
+        std::vector<size_t> freePartitions_; // empty partitions of partitionGraph_
+        struct
+        {
+            std::vector<size_t> component; // by vertex
+            std::vector<size_t> roots;     // by component
+            std::vector<size_t> queue;
+            std::vector<bool> claimed;     // by partition of the frame
+            std::vector<size_t> partitionOfComponent;
+            std::vector<size_t> touched;
+        } relabeling_; // scratch of relabelFrame
     };
 
     class ConstraintGenerator
@@ -969,13 +1392,11 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
         std::vector<size_t> variables_;
     };
 
-    // create log file/replace existing log file with empty log file
-    {
-        std::ofstream file(solutionName + "-optimization-log.txt");
-        file.close();
-    }
-
     Data data(problemGraph);
+
+    // create log file/replace existing log file with empty log file
+    data.log.configure(logSettings);
+    data.log.open(solutionName + "-optimization-log.txt");
     data.costBirth = costBirth;
     data.costTermination = costTermination;
     data.enforceBifurcationConstraint = enforceBifurcationConstraint;
@@ -1043,11 +1464,7 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
         // each 3-wheel is counted three times...
         stream << "Added " << nConstraints/3 << " 3-wheel inequalities.\n";
         std::cout << stream.str();
-        {
-            std::ofstream file(solutionName + "-optimization-log.txt", std::ofstream::out | std::ofstream::app);
-            file << stream.str();
-            file.close();
-        }
+        data.log.append(stream.str());
     }
 
     data.timer.start();
@@ -1072,13 +1489,12 @@ Solution solver_ilp(ProblemGraph const& problemGraph, double costTermination = .
         if (enforceBifurcationConstraint)
             stream << " 0";
 
-        stream << " 0 0\n";
+        stream << " 0 0 0\n"; // separation time, frames skipped and separated
 
         std::cout << stream.str();
 
-        std::ofstream file(solutionName + "-optimization-log.txt", std::ofstream::out | std::ofstream::app);
-        file << stream.str();
-        file.close();
+        data.log.append(stream.str());
+        data.log.flush();
     }
 
     Solution solution;
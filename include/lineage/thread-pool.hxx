@@ -0,0 +1,235 @@
+#pragma once
+#ifndef LINEAGE_THREAD_POOL_HXX
+#define LINEAGE_THREAD_POOL_HXX
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lineage {
+
+/// Persistent pool of worker threads with work stealing.
+///
+/// parallelFor distributes its tasks round-robin over the queues of the
+/// workers. A worker takes tasks from the back of its own queue and steals
+/// from the front of the others when its queue is empty. The calling thread
+/// executes tasks as well while it waits, such that parallelFor may be
+/// nested (e.g. branching optimizers called from within a task) without
+/// deadlock. A pool of n threads starts n - 1 workers; with a single thread,
+/// all tasks run on the calling thread.
+class ThreadPool
+{
+public:
+    /// numberOfThreads = 0 uses all hardware threads.
+    explicit ThreadPool(size_t numberOfThreads = 0)
+    {
+        if (numberOfThreads == 0)
+            numberOfThreads =
+                std::max<size_t>(1, std::thread::hardware_concurrency());
+
+        queues_.resize(numberOfThreads - 1);
+        for (auto& queue : queues_)
+            queue.reset(new Queue);
+
+        for (size_t i = 0; i < queues_.size(); ++i)
+            workers_.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeUp_.notify_all();
+
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    /// including the calling thread.
+    size_t numberOfThreads() const { return workers_.size() + 1; }
+
+    /// call f(i) for all i in [0, n) and return once all calls have
+    /// returned. The first exception thrown by f is rethrown.
+    template <class F>
+    void parallelFor(const size_t n, F f)
+    {
+        if (n == 0)
+            return;
+
+        if (workers_.empty() || n == 1) {
+            for (size_t i = 0; i < n; ++i)
+                f(i);
+            return;
+        }
+
+        auto group = std::make_shared<Group>(n);
+        auto run = [group, &f](size_t i) {
+            try {
+                f(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                if (!group->exception)
+                    group->exception = std::current_exception();
+            }
+
+            if (--group->remaining == 0) {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                group->done.notify_all();
+            }
+        };
+
+        // counted before they are queued, such that pending_ never drops
+        // below the number of queued tasks.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ += n;
+        }
+
+        const size_t first = next_++;
+        for (size_t i = 0; i < n; ++i) {
+            auto& queue = *queues_[(first + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.emplace_back(std::bind(run, i));
+        }
+        wakeUp_.notify_all();
+
+        // help while waiting.
+        Task task;
+        while (group->remaining > 0) {
+            if (steal(queues_.size(), task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(group->mutex);
+            group->done.wait(lock, [&] { return group->remaining == 0; });
+        }
+
+        if (group->exception)
+            std::rethrow_exception(group->exception);
+    }
+
+    /// pool used by Data unless another pool is assigned.
+    static std::shared_ptr<ThreadPool> shared()
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex());
+        auto& pool = sharedInstance();
+        if (!pool)
+            pool = std::make_shared<ThreadPool>();
+        return pool;
+    }
+
+    /// replace the shared pool. Data constructed before keeps the old one.
+    static void setSharedNumberOfThreads(const size_t numberOfThreads)
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex());
+        sharedInstance() = std::make_shared<ThreadPool>(numberOfThreads);
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct Group
+    {
+        explicit Group(size_t n)
+          : remaining(n)
+        {
+        }
+
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr exception;
+    };
+
+    // own queue first (from the back), then the other queues (from the
+    // front). self = queues_.size() for threads outside of the pool.
+    bool steal(const size_t self, Task& task)
+    {
+        if (self < queues_.size() && pop(*queues_[self], task, true))
+            return true;
+
+        for (size_t i = 1; i <= queues_.size(); ++i)
+            if (pop(*queues_[(self + i) % queues_.size()], task, false))
+                return true;
+
+        return false;
+    }
+
+    bool pop(Queue& queue, Task& task, const bool back)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return false;
+
+        if (back) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        --pending_;
+        return true;
+    }
+
+    void work(const size_t self)
+    {
+        Task task;
+        while (true) {
+            if (steal(self, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (stop_ && pending_ == 0)
+                return;
+        }
+    }
+
+    static std::mutex& sharedMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::shared_ptr<ThreadPool>& sharedInstance()
+    {
+        static std::shared_ptr<ThreadPool> pool;
+        return pool;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::atomic<size_t> pending_{ 0 }; // queued tasks
+    std::atomic<size_t> next_{ 0 };
+    bool stop_{ false };
+};
+
+} // namespace lineage
+
+#endif
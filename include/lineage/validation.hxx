@@ -2,6 +2,8 @@
 #ifndef LINAGE_VALIDATION_HXX
 #define LINAGE_VALIDATION_HXX
 
+#include <set>
+
 #include <andres/graph/components.hxx>
 #include <andres/graph/shortest-paths.hxx>
 
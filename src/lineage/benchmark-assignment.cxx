@@ -0,0 +1,258 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tclap/CmdLine.h>
+
+#include <andres/graph/digraph.hxx>
+#include <levinkov/timer.hxx>
+#include <markurem/munkres.hxx>
+
+#include "lineage/heuristics/greedy-lineage.hxx"
+#include "lineage/heuristics/hungarian-branching.hxx"
+#include "lineage/heuristics/partition-graph.hxx"
+#include "lineage/problem-graph.hxx"
+
+using namespace std;
+
+struct Parameters {
+    string edgesFileName;
+    string nodesFileName;
+    double biasSpatial { .5 };
+    double biasTemporal { .5 };
+    double terminationCost { .0 };
+    double birthCost { .0 };
+    size_t repetitions { 10 };
+};
+
+Parameters parseCommandLine(int argc, char** argv)
+try
+{
+    Parameters parameters;
+
+    TCLAP::CmdLine tclap("benchmark-assignment", ' ', "1.0");
+    TCLAP::ValueArg<string> argNodesFileName("n", "nodes-file", "nodes information", true, parameters.nodesFileName, "nodes-file", tclap);
+    TCLAP::ValueArg<string> argEdgesFileName("e", "edges-file", "edges information", true, parameters.edgesFileName, "edges-file", tclap);
+    TCLAP::ValueArg<double> argBiasSpatial("b", "cut-prior-spatial", "cut prior spatial", false, parameters.biasSpatial, "cut prior spatial", tclap);
+    TCLAP::ValueArg<double> argBiasTemporal("t", "cut-prior-temporal", "cut prior temporal", false, parameters.biasTemporal, "cut prior temporal", tclap);
+    TCLAP::ValueArg<double> argTerminationCost("T", "termination-cost", "early termination cost", false, parameters.terminationCost, "early termination cost", tclap);
+    TCLAP::ValueArg<double> argBirthCost("B", "birth-cost", "birth cost", false, parameters.birthCost, "birth cost", tclap);
+    TCLAP::ValueArg<size_t> argRepetitions("r", "repetitions", "number of repetitions", false, parameters.repetitions, "repetitions", tclap);
+
+    tclap.parse(argc, argv);
+
+    parameters.edgesFileName = argEdgesFileName.getValue();
+    parameters.nodesFileName = argNodesFileName.getValue();
+    parameters.biasSpatial = argBiasSpatial.getValue();
+    parameters.biasTemporal = argBiasTemporal.getValue();
+    parameters.terminationCost = argTerminationCost.getValue();
+    parameters.birthCost = argBirthCost.getValue();
+    parameters.repetitions = argRepetitions.getValue();
+
+    return parameters;
+}
+catch (TCLAP::ArgException& e)
+{
+    throw runtime_error(e.error());
+}
+
+// solve with markurem::matching::Matching, which is what the branching
+// optimizers used before the sparse assignment.
+double solveMunkres(lineage::heuristics::SparseAssignment const& assignment)
+{
+    typedef andres::graph::Digraph<> Graph;
+
+    const auto numberOfRows = assignment.numberOfRows();
+
+    Graph graph(numberOfRows + assignment.numberOfColumns());
+    vector<double> costs;
+    vector<int> mask(assignment.numberOfEdges(), 0);
+
+    for (size_t edge = 0; edge < assignment.numberOfEdges(); ++edge)
+    {
+        graph.insertEdge(assignment.rowOfEdge(edge), numberOfRows + assignment.columnOfEdge(edge));
+        costs.push_back(assignment.costOfEdge(edge));
+    }
+
+    auto const originalCosts = costs;
+
+    markurem::matching::Matching<Graph, vector<double>, vector<int>> matching(graph, costs, mask);
+    matching.run();
+
+    double objective = .0;
+    for (size_t edge = 0; edge < mask.size(); ++edge)
+        if (mask[edge] == 1)
+            objective += originalCosts[edge];
+
+    return objective;
+}
+
+int main(int argc, char** argv)
+try
+{
+    auto parameters = parseCommandLine(argc, argv);
+
+    auto problem = lineage::loadProblem(parameters.nodesFileName, parameters.edgesFileName);
+
+    lineage::NegativeLogProbabilityRatio<> func;
+    for (auto& e : problem.edges)
+        if (e.t0 != e.t1)
+            e.weight = func(e.weight) + func(parameters.biasTemporal);
+        else
+            e.weight = func(e.weight) + func(parameters.biasSpatial);
+
+    lineage::ProblemGraph problemGraph(problem);
+    lineage::Data data(problemGraph);
+
+    lineage::OptimizationLog::Settings logSettings;
+    logSettings.enabled = false;
+    data.log.configure(logSettings);
+
+    data.costTermination = parameters.terminationCost;
+    data.costBirth = parameters.birthCost;
+    data.enforceBifurcationConstraint = true;
+    data.incrementalReproposal = true;
+    data.maxDistance = numeric_limits<size_t>::max();
+
+    for (auto const& e : problem.edges)
+        data.costs.push_back(e.weight);
+    if (data.costTermination > 0.0)
+        data.costs.insert(data.costs.end(), problem.nodes.size(), data.costTermination);
+    if (data.costBirth > 0.0)
+        data.costs.insert(data.costs.end(), problem.nodes.size(), data.costBirth);
+
+    // frame pairs are taken from the partitions found by GLA, as in KLB.
+    lineage::Solution solution;
+    {
+        lineage::heuristics::GreedyLineageAgglomeration<> gla(data);
+        gla.setSilent(true);
+        gla.optimize();
+        solution = gla.getSolution();
+    }
+
+    lineage::heuristics::PartitionGraph partitionGraph(data, solution.edge_labels);
+
+    vector<vector<size_t>> partitions(problemGraph.numberOfFrames());
+    for (size_t p = 0; p < partitionGraph.numberOfVertices(); ++p)
+        if (!partitionGraph.partitions_[p].empty())
+            partitions[partitionGraph.frameOfPartition(p)].push_back(p);
+
+    vector<lineage::heuristics::SparseAssignment> assignments(problemGraph.numberOfFrames() - 1);
+    vector<size_t> branchingEdges;
+    size_t numberOfRows = 0;
+    size_t numberOfEdges = 0;
+    for (size_t t = 0; t + 1 < problemGraph.numberOfFrames(); ++t)
+    {
+        lineage::heuristics::branching::buildStepAssignment(partitionGraph, partitions[t], partitions[t + 1], assignments[t], branchingEdges);
+        numberOfRows += assignments[t].numberOfRows();
+        numberOfEdges += assignments[t].numberOfEdges();
+    }
+
+    // the optimizers re-solve an assignment after the partitions have
+    // changed. To time a warm start on different costs, every cost of the
+    // perturbed assignments is scaled by a random factor in [0.9, 1.1].
+    vector<lineage::heuristics::SparseAssignment> perturbed(assignments.size());
+    {
+        mt19937 generator(42);
+        uniform_real_distribution<double> factor(.9, 1.1);
+        for (size_t t = 0; t < assignments.size(); ++t)
+        {
+            perturbed[t].reset(assignments[t].numberOfRows(), assignments[t].numberOfColumns());
+            for (size_t edge = 0; edge < assignments[t].numberOfEdges(); ++edge)
+                perturbed[t].addEdge(assignments[t].rowOfEdge(edge), assignments[t].columnOfEdge(edge), assignments[t].costOfEdge(edge) * factor(generator));
+        }
+    }
+
+    levinkov::Timer timerMunkres;
+    levinkov::Timer timerSparse;
+    levinkov::Timer timerWarm;
+    levinkov::Timer timerPerturbed;
+    levinkov::Timer timerPerturbedWarm;
+
+    vector<double> objectivesMunkres(assignments.size());
+    vector<double> objectivesSparse(assignments.size());
+    vector<double> objectivesWarm(assignments.size());
+    vector<double> objectivesPerturbed(assignments.size());
+    vector<double> objectivesPerturbedWarm(assignments.size());
+
+    for (size_t i = 0; i < parameters.repetitions; ++i)
+    {
+        timerMunkres.start();
+        for (size_t t = 0; t < assignments.size(); ++t)
+            objectivesMunkres[t] = solveMunkres(assignments[t]);
+        timerMunkres.stop();
+
+        timerSparse.start();
+        for (size_t t = 0; t < assignments.size(); ++t)
+        {
+            assignments[t].setColumnPotentials(vector<double>(assignments[t].numberOfColumns(), .0));
+            objectivesSparse[t] = assignments[t].solve();
+        }
+        timerSparse.stop();
+
+        // re-solve the same problem, starting from its own optimal
+        // potentials. This is a best case for the warm start.
+        timerWarm.start();
+        for (size_t t = 0; t < assignments.size(); ++t)
+            objectivesWarm[t] = assignments[t].solve();
+        timerWarm.stop();
+
+        timerPerturbed.start();
+        for (size_t t = 0; t < assignments.size(); ++t)
+        {
+            perturbed[t].setColumnPotentials(vector<double>(perturbed[t].numberOfColumns(), .0));
+            objectivesPerturbed[t] = perturbed[t].solve();
+        }
+        timerPerturbed.stop();
+
+        // solve the perturbed problem, starting from the potentials of the
+        // unperturbed one.
+        timerPerturbedWarm.start();
+        for (size_t t = 0; t < assignments.size(); ++t)
+        {
+            perturbed[t].setColumnPotentials(assignments[t].columnPotentials());
+            objectivesPerturbedWarm[t] = perturbed[t].solve();
+        }
+        timerPerturbedWarm.stop();
+    }
+
+    double maxDifference = .0;
+    for (size_t t = 0; t < assignments.size(); ++t)
+    {
+        maxDifference = max(maxDifference, abs(objectivesMunkres[t] - objectivesSparse[t]));
+        maxDifference = max(maxDifference, abs(objectivesMunkres[t] - objectivesWarm[t]));
+    }
+
+    if (maxDifference > 1e-6)
+        throw runtime_error("sparse assignment does not reproduce the objective of Munkres.");
+
+    for (size_t t = 0; t < assignments.size(); ++t)
+        if (abs(objectivesPerturbed[t] - objectivesPerturbedWarm[t]) > 1e-6)
+            throw runtime_error("warm start changes the objective of the perturbed assignment.");
+
+    const auto msMunkres = 1000.0 * timerMunkres.get_elapsed_seconds() / parameters.repetitions;
+    const auto msSparse = 1000.0 * timerSparse.get_elapsed_seconds() / parameters.repetitions;
+    const auto msWarm = 1000.0 * timerWarm.get_elapsed_seconds() / parameters.repetitions;
+    const auto msPerturbed = 1000.0 * timerPerturbed.get_elapsed_seconds() / parameters.repetitions;
+    const auto msPerturbedWarm = 1000.0 * timerPerturbedWarm.get_elapsed_seconds() / parameters.repetitions;
+
+    cout << assignments.size() << " frame pairs, " << numberOfRows << " rows, " << numberOfEdges << " edges, "
+        << parameters.repetitions << " repetitions" << endl
+        << setw(32) << "munkres:" << setw(12) << msMunkres << " ms" << endl
+        << setw(32) << "sparse:" << setw(12) << msSparse << " ms" << endl
+        << setw(32) << "sparse (warm, best case):" << setw(12) << msWarm << " ms" << endl
+        << setw(32) << "sparse (perturbed):" << setw(12) << msPerturbed << " ms" << endl
+        << setw(32) << "sparse (perturbed, warm):" << setw(12) << msPerturbedWarm << " ms" << endl
+        << setw(32) << "speedup:" << setw(12) << msMunkres / msSparse << endl;
+
+    return 0;
+}
+catch (const runtime_error& error)
+{
+    cerr << "error: " << error.what() << endl;
+    return 1;
+}
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include <tclap/CmdLine.h>
+
+#include <levinkov/timer.hxx>
+
+#include "lineage/problem.hxx"
+
+using namespace std;
+
+struct Parameters {
+    string edgesFileName;
+    string nodesFileName;
+    size_t repetitions { 10 };
+    size_t numberOfThreads { 0 };
+};
+
+Parameters parseCommandLine(int argc, char** argv)
+try
+{
+    Parameters parameters;
+
+    TCLAP::CmdLine tclap("benchmark-loading", ' ', "1.0");
+    TCLAP::ValueArg<string> argNodesFileName("n", "nodes-file", "nodes information", true, parameters.nodesFileName, "nodes-file", tclap);
+    TCLAP::ValueArg<string> argEdgesFileName("e", "edges-file", "edges information", true, parameters.edgesFileName, "edges-file", tclap);
+    TCLAP::ValueArg<size_t> argRepetitions("r", "repetitions", "number of repetitions", false, parameters.repetitions, "repetitions", tclap);
+    TCLAP::ValueArg<size_t> argNumberOfThreads("j", "threads", "number of threads of the parallel loader (0: all)", false, parameters.numberOfThreads, "threads", tclap);
+
+    tclap.parse(argc, argv);
+
+    parameters.edgesFileName = argEdgesFileName.getValue();
+    parameters.nodesFileName = argNodesFileName.getValue();
+    parameters.repetitions = argRepetitions.getValue();
+    parameters.numberOfThreads = argNumberOfThreads.getValue();
+
+    return parameters;
+}
+catch (TCLAP::ArgException& e)
+{
+    throw runtime_error(e.error());
+}
+
+namespace lineage {
+
+bool operator==(const Node& a, const Node& b)
+{
+    return a.t == b.t && a.id == b.id && a.cx == b.cx && a.cy == b.cy
+        && a.probability_birth_termination == b.probability_birth_termination;
+}
+
+bool operator==(const Edge& a, const Edge& b)
+{
+    return a.t0 == b.t0 && a.v0 == b.v0 && a.t1 == b.t1 && a.v1 == b.v1
+        && a.weight == b.weight;
+}
+
+} // namespace lineage
+
+int main(int argc, char** argv)
+try
+{
+    auto parameters = parseCommandLine(argc, argv);
+
+    lineage::Problem sequential;
+    lineage::Problem parallel;
+
+    levinkov::Timer timerSequential;
+    levinkov::Timer timerParallel;
+
+    for (size_t i = 0; i < parameters.repetitions; ++i)
+    {
+        timerSequential.start();
+        lineage::loadNodes(parameters.nodesFileName, sequential);
+        lineage::loadEdges(parameters.edgesFileName, sequential);
+        timerSequential.stop();
+
+        timerParallel.start();
+        lineage::loadNodesParallel(parameters.nodesFileName, parallel, parameters.numberOfThreads);
+        lineage::loadEdgesParallel(parameters.edgesFileName, parallel, parameters.numberOfThreads);
+        timerParallel.stop();
+    }
+
+    if (sequential.nodes != parallel.nodes || sequential.edges != parallel.edges || sequential.node_offsets != parallel.node_offsets)
+        throw runtime_error("parallel loader does not reproduce the sequential loader.");
+
+    const auto msSequential = 1000.0 * timerSequential.get_elapsed_seconds() / parameters.repetitions;
+    const auto msParallel = 1000.0 * timerParallel.get_elapsed_seconds() / parameters.repetitions;
+
+    cout << sequential.nodes.size() << " nodes, " << sequential.edges.size() << " edges, "
+        << parameters.repetitions << " repetitions" << endl
+        << setw(12) << "sequential:" << setw(12) << msSequential << " ms" << endl
+        << setw(12) << "parallel:" << setw(12) << msParallel << " ms" << endl
+        << setw(12) << "speedup:" << setw(12) << msSequential / msParallel << endl;
+
+    return 0;
+}
+catch (const runtime_error& error)
+{
+    cerr << "error: " << error.what() << endl;
+    return 1;
+}
@@ -0,0 +1,227 @@
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tclap/CmdLine.h>
+
+#include <levinkov/timer.hxx>
+
+#include "lineage/heuristics/heuristic-utility.hxx"
+#include "lineage/solver-ilp.hxx"
+
+using namespace std;
+
+struct Parameters {
+    string edgesFileName;
+    string nodesFileName;
+    vector<string> solutionFileNames;
+    double biasSpatial { .5 };
+    double biasTemporal { .5 };
+    double terminationCost { .0 };
+    double birthCost { .0 };
+    bool bifurcationConstraint { false };
+    double perturbation { .0 };
+    size_t repetitions { 10 };
+    size_t numberOfThreads { 0 };
+};
+
+Parameters parseCommandLine(int argc, char** argv)
+try
+{
+    Parameters parameters;
+
+    TCLAP::CmdLine tclap("benchmark-separation", ' ', "1.0");
+    TCLAP::ValueArg<string> argNodesFileName("n", "nodes-file", "nodes information", true, parameters.nodesFileName, "nodes-file", tclap);
+    TCLAP::ValueArg<string> argEdgesFileName("e", "edges-file", "edges information", true, parameters.edgesFileName, "edges-file", tclap);
+    TCLAP::MultiArg<string> argSolutionFileNames("s", "solution-file", "integer solution, one label per edge (fragment-edge-labels) or per variable (variables-values)", true, "solution-file", tclap);
+    TCLAP::ValueArg<double> argBiasSpatial("b", "cut-prior-spatial", "cut prior spatial", false, parameters.biasSpatial, "cut prior spatial", tclap);
+    TCLAP::ValueArg<double> argBiasTemporal("t", "cut-prior-temporal", "cut prior temporal", false, parameters.biasTemporal, "cut prior temporal", tclap);
+    TCLAP::ValueArg<double> argTerminationCost("T", "termination-cost", "early termination cost", false, parameters.terminationCost, "early termination cost", tclap);
+    TCLAP::ValueArg<double> argBirthCost("B", "birth-cost", "birth cost", false, parameters.birthCost, "birth cost", tclap);
+    TCLAP::SwitchArg argBifurcationConstraint("F", "bifurcation-constraint", "Enforce bifurcation contraint. (Default: disabled).", tclap);
+    TCLAP::ValueArg<double> argPerturbation("p", "perturbation", "fraction of edge labels flipped at random (fixed seed)", false, parameters.perturbation, "fraction", tclap);
+    TCLAP::ValueArg<size_t> argRepetitions("r", "repetitions", "number of repetitions", false, parameters.repetitions, "repetitions", tclap);
+    TCLAP::ValueArg<size_t> argNumberOfThreads("", "threads", "size of the thread pool (0: all cores)", false, parameters.numberOfThreads, "threads", tclap);
+
+    tclap.parse(argc, argv);
+
+    parameters.edgesFileName = argEdgesFileName.getValue();
+    parameters.nodesFileName = argNodesFileName.getValue();
+    parameters.solutionFileNames = argSolutionFileNames.getValue();
+    parameters.biasSpatial = argBiasSpatial.getValue();
+    parameters.biasTemporal = argBiasTemporal.getValue();
+    parameters.terminationCost = argTerminationCost.getValue();
+    parameters.birthCost = argBirthCost.getValue();
+    parameters.bifurcationConstraint = argBifurcationConstraint.getValue();
+    parameters.perturbation = argPerturbation.getValue();
+    parameters.repetitions = argRepetitions.getValue();
+    parameters.numberOfThreads = argNumberOfThreads.getValue();
+
+    return parameters;
+}
+catch (TCLAP::ArgException& e)
+{
+    throw runtime_error(e.error());
+}
+
+// stored solutions and measurements, shared with the ReplayILP constructed by lineage::solver_ilp.
+struct Replay {
+    vector<vector<double>> solutions; // labels by variable
+    size_t repetitions { 1 };
+
+    size_t numberOfConstraints { 0 };
+    size_t numberOfNonZeros { 0 };
+    levinkov::Timer timerSeparation;
+    levinkov::Timer timerFeasibleSolution;
+} replay;
+
+// Stand-in for the ILP solver of lineage::solver_ilp. optimize() passes each stored solution to the
+// callback, as the solver does for each new incumbent, and times separation and the feasible solution.
+class ReplayILP
+{
+public:
+    class Callback
+    {
+    public:
+        Callback(ReplayILP& ilp) :
+            ilp_(ilp)
+        {}
+
+        virtual ~Callback() = default;
+
+        virtual void separateAndAddLazyConstraints() = 0;
+        virtual void computeFeasibleSolution() = 0;
+
+        double label(size_t variableIndex)
+        {
+            return (*ilp_.solution_)[variableIndex];
+        }
+
+        void setLabel(size_t, double)
+        {}
+
+    protected:
+        template<class VariableIndexIterator, class CoefficientIterator>
+        void addLazyConstraint(VariableIndexIterator viBegin, VariableIndexIterator viEnd, CoefficientIterator, double, double)
+        {
+            ++replay.numberOfConstraints;
+            replay.numberOfNonZeros += viEnd - viBegin;
+        }
+
+        double objectiveBest_ { .0 };
+        double objectiveBound_ { .0 };
+
+    private:
+        ReplayILP& ilp_;
+    };
+
+    void setRelativeGap(double) {}
+    void setAbsoluteGap(double) {}
+    void addVariables(size_t, double const*) {}
+    void setBranchPrio(size_t, int) {}
+    template<class Iterator> void setStart(Iterator) {}
+    template<class VariableIndexIterator, class CoefficientIterator>
+    void addConstraint(VariableIndexIterator, VariableIndexIterator, CoefficientIterator, double, double) {}
+    void setCallback(Callback& callback) { callback_ = &callback; }
+
+    void optimize()
+    {
+        for (size_t i = 0; i < replay.repetitions; ++i)
+            for (auto const& solution : replay.solutions)
+            {
+                solution_ = &solution;
+
+                replay.timerSeparation.start();
+                callback_->separateAndAddLazyConstraints();
+                replay.timerSeparation.stop();
+
+                replay.timerFeasibleSolution.start();
+                callback_->computeFeasibleSolution();
+                replay.timerFeasibleSolution.stop();
+            }
+    }
+
+    double objective() const { return .0; }
+    double bound() const { return .0; }
+    double gap() const { return .0; }
+    double label(size_t variableIndex) const { return (*solution_)[variableIndex]; }
+
+private:
+    vector<double> const* solution_ { nullptr };
+    Callback* callback_ { nullptr };
+};
+
+int main(int argc, char** argv)
+try
+{
+    auto parameters = parseCommandLine(argc, argv);
+
+    if (parameters.numberOfThreads > 0)
+        lineage::ThreadPool::setSharedNumberOfThreads(parameters.numberOfThreads);
+
+    auto problem = lineage::loadProblem(parameters.nodesFileName, parameters.edgesFileName);
+
+    lineage::NegativeLogProbabilityRatio<> func;
+    for (auto& e : problem.edges)
+        if (e.t0 != e.t1)
+            e.weight = func(e.weight) + func(parameters.biasTemporal);
+        else
+            e.weight = func(e.weight) + func(parameters.biasSpatial);
+
+    lineage::ProblemGraph problemGraph(problem);
+
+    auto numberOfVariables = problem.edges.size();
+    if (parameters.terminationCost > .0)
+        numberOfVariables += problem.nodes.size();
+    if (parameters.birthCost > .0)
+        numberOfVariables += problem.nodes.size();
+
+    // labels of all variables. Labels of termination and birth are derived from the edge labels if not stored.
+    mt19937 randomNumberGenerator(42);
+    bernoulli_distribution flip(parameters.perturbation);
+
+    for (auto const& fileName : parameters.solutionFileNames)
+    {
+        auto labels = lineage::loadSolution(fileName).edge_labels;
+
+        if (labels.size() == problem.edges.size())
+            lineage::heuristics::generateLabelsForILP(problemGraph, labels, parameters.terminationCost, parameters.birthCost);
+
+        if (labels.size() != numberOfVariables)
+            throw runtime_error(fileName + " does not have one label per edge or per variable.");
+
+        for (size_t e = 0; e < problem.edges.size(); ++e)
+            if (flip(randomNumberGenerator))
+                labels[e] = 1 - labels[e];
+
+        replay.solutions.emplace_back(labels.begin(), labels.end());
+    }
+
+    replay.repetitions = parameters.repetitions;
+
+    lineage::OptimizationLog::Settings logSettings;
+    logSettings.enabled = false;
+
+    lineage::solver_ilp<ReplayILP>(problemGraph, parameters.terminationCost, parameters.birthCost, parameters.bifurcationConstraint, false, false, "benchmark-separation", logSettings);
+
+    const auto numberOfCalls = replay.repetitions * replay.solutions.size();
+    const auto msSeparation = 1000.0 * replay.timerSeparation.get_elapsed_seconds() / numberOfCalls;
+    const auto msFeasibleSolution = 1000.0 * replay.timerFeasibleSolution.get_elapsed_seconds() / numberOfCalls;
+
+    cout << replay.solutions.size() << " solutions, " << parameters.repetitions << " repetitions" << endl
+        << setw(24) << "constraints:" << setw(12) << replay.numberOfConstraints / numberOfCalls << endl
+        << setw(24) << "non-zeros:" << setw(12) << replay.numberOfNonZeros / numberOfCalls << endl
+        << setw(24) << "separation:" << setw(12) << msSeparation << " ms" << endl
+        << setw(24) << "feasible solution:" << setw(12) << msFeasibleSolution << " ms" << endl;
+
+    return 0;
+}
+catch (const runtime_error& error)
+{
+    cerr << "error: " << error.what() << endl;
+    return 1;
+}
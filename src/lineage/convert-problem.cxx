@@ -0,0 +1,59 @@
+#include <stdexcept>
+#include <iostream>
+#include <string>
+
+#include <tclap/CmdLine.h>
+
+#include "lineage/problem.hxx"
+
+using namespace std;
+
+struct Parameters {
+    string edgesFileName;
+    string nodesFileName;
+    string outputFileName;
+};
+
+Parameters parseCommandLine(int argc, char** argv)
+try
+{
+    Parameters parameters;
+
+    TCLAP::CmdLine tclap("convert-problem", ' ', "1.0");
+    TCLAP::ValueArg<string> argNodesFileName("n", "nodes-file", "nodes information", true, parameters.nodesFileName, "nodes-file", tclap);
+    TCLAP::ValueArg<string> argEdgesFileName("e", "edges-file", "edges information", true, parameters.edgesFileName, "edges-file", tclap);
+    TCLAP::ValueArg<string> argOutputFileName("o", "output-file", "binary problem file", true, parameters.outputFileName, "output-file", tclap);
+
+    tclap.parse(argc, argv);
+
+    parameters.edgesFileName = argEdgesFileName.getValue();
+    parameters.nodesFileName = argNodesFileName.getValue();
+    parameters.outputFileName = argOutputFileName.getValue();
+
+    return parameters;
+}
+catch (TCLAP::ArgException& e)
+{
+    throw runtime_error(e.error());
+}
+
+int main(int argc, char** argv)
+try
+{
+    auto parameters = parseCommandLine(argc, argv);
+    auto problem = lineage::loadProblem(parameters.nodesFileName, parameters.edgesFileName);
+
+    lineage::saveBinaryProblem(parameters.outputFileName, problem);
+
+    cout << "wrote " << problem.nodes.size() << " nodes, "
+        << problem.edges.size() << " edges and "
+        << problem.node_offsets.size() << " node offsets to "
+        << parameters.outputFileName << endl;
+
+    return 0;
+}
+catch (const runtime_error& error)
+{
+    cerr << "error: " << error.what() << endl;
+    return 1;
+}
@@ -8,6 +8,7 @@
 #include "lineage/heuristics/greedy-lineage.hxx"
 #include "lineage/heuristics/hungarian-branching.hxx"
 #include "lineage/heuristics/partition-optimizer.hxx"
+#include "lineage/heuristics/temporal-decomposition.hxx"
 
 struct Parameters
 {
@@ -19,7 +20,13 @@ struct Parameters
     double terminationCost{ .0 };
     double birthCost{ .0 };
     bool bifurcationConstraint{ false };
+    lineage::OptimizationLog::Settings logSettings;
     size_t maxDistance{ std::numeric_limits<size_t>::max() };
+    size_t numberOfBlocks{ 1 };
+    size_t numberOfThreads{ 0 };
+    bool localBranching{ false };
+    lineage::heuristics::DecompositionSettings decomposition;
+    lineage::heuristics::PartitionOptimizerSettings partitionSettings;
 };
 
 Parameters
@@ -48,12 +55,52 @@ parseCommandLine(int argc, char** argv) try {
     TCLAP::ValueArg<double> argBirthCost("B", "birth-cost", "birth cost", false,
                                          parameters.birthCost, "birth cost",
                                          tclap);
-    TCLAP::ValueArg<size_t> argMaxDistance("L", "max-dist", "maximum distance",
-                                           false, parameters.maxDistance,
-                                           "max dist", tclap);
+    TCLAP::ValueArg<size_t> argMaxDistance(
+        "L", "max-dist",
+        "maximum distance of the local branching problems (requires "
+        "--local-branching)",
+        false, parameters.maxDistance, "max dist", tclap);
+    TCLAP::ValueArg<size_t> argNumberOfBlocks(
+        "", "blocks",
+        "number of temporal blocks solved in parallel (0: one per thread, "
+        "1: no decomposition)",
+        false, parameters.numberOfBlocks, "blocks", tclap);
+    TCLAP::ValueArg<size_t> argOverlap(
+        "", "overlap", "frames added on both sides of a temporal block", false,
+        parameters.decomposition.overlap, "frames", tclap);
+    TCLAP::ValueArg<size_t> argNumberOfThreads(
+        "", "threads", "size of the thread pool (0: all cores)", false,
+        parameters.numberOfThreads, "threads", tclap);
+    TCLAP::SwitchArg argLocalBranching(
+        "", "local-branching",
+        "Evaluate moves by local branching problems instead of repairing "
+        "the global branching incrementally.",
+        tclap);
+    TCLAP::SwitchArg argParallelBipartitions(
+        "", "parallel-bipartitions",
+        "Improve the pairs of partitions of every other frame in "
+        "parallel.",
+        tclap);
+    TCLAP::ValueArg<size_t> argNumberOfMoveCandidates(
+        "", "move-candidates",
+        "number of moves of the highest in-frame gain that are evaluated "
+        "with the branching in each step of a bipartition (0: all moves)",
+        false, parameters.partitionSettings.numberOfMoveCandidates, "moves",
+        tclap);
     TCLAP::SwitchArg argBifurcationConstraint(
         "F", "bifurcation-constraint",
         "Enforce bifurcation contraint. (Default: disabled).", tclap);
+    TCLAP::SwitchArg argDisableLog(
+        "", "no-optimization-log",
+        "Do not write <solution-name>-optimization-log.txt.", tclap);
+    TCLAP::ValueArg<double> argLogFlushInterval(
+        "", "log-flush-interval",
+        "seconds between writes of the optimization log", false,
+        parameters.logSettings.flushInterval, "seconds", tclap);
+    TCLAP::ValueArg<size_t> argLogFlushSize(
+        "", "log-flush-size",
+        "bytes of the optimization log buffered before they are written",
+        false, parameters.logSettings.flushSize, "bytes", tclap);
 
     tclap.parse(argc, argv);
 
@@ -66,6 +113,23 @@ parseCommandLine(int argc, char** argv) try {
     parameters.birthCost = argBirthCost.getValue();
     parameters.maxDistance = argMaxDistance.getValue();
     parameters.bifurcationConstraint = argBifurcationConstraint.getValue();
+    parameters.numberOfBlocks = argNumberOfBlocks.getValue();
+    parameters.decomposition.numberOfBlocks = parameters.numberOfBlocks;
+    parameters.decomposition.overlap = argOverlap.getValue();
+    parameters.numberOfThreads = argNumberOfThreads.getValue();
+    parameters.localBranching = argLocalBranching.getValue();
+    parameters.partitionSettings.parallelBipartitions =
+        argParallelBipartitions.getValue();
+    parameters.partitionSettings.numberOfMoveCandidates =
+        argNumberOfMoveCandidates.getValue();
+    parameters.logSettings.enabled = !argDisableLog.getValue();
+    parameters.logSettings.flushInterval = argLogFlushInterval.getValue();
+    parameters.logSettings.flushSize = argLogFlushSize.getValue();
+
+    // the incremental branching is global and has no locality.
+    if (argMaxDistance.isSet() && !parameters.localBranching)
+        throw std::runtime_error(
+            "Maximum distance (-L) requires --local-branching");
 
     if (parameters.biasSpatial < std::numeric_limits<double>::epsilon() ||
         parameters.biasSpatial > 1.0 - std::numeric_limits<double>::epsilon())
@@ -87,7 +151,15 @@ parseCommandLine(int argc, char** argv) try {
               << (parameters.bifurcationConstraint ? "yes" : "no") << std::endl
               << "- locality (max distance): " << parameters.maxDistance
               << std::endl
-              << "- Solver: Hungarian matching" << std::endl
+              << "- Solver: Hungarian matching ("
+              << (parameters.localBranching ? "local" : "incremental") << ")"
+              << std::endl
+              << "- move candidates (0: all): "
+              << parameters.partitionSettings.numberOfMoveCandidates
+              << std::endl
+              << "- temporal blocks: " << parameters.numberOfBlocks
+              << " (overlap: " << parameters.decomposition.overlap << ")"
+              << std::endl
               << std::endl;
 
     return parameters;
@@ -95,10 +167,37 @@ parseCommandLine(int argc, char** argv) try {
     throw std::runtime_error(e.error());
 }
 
+// heuristic for initial lineage.
+using Initializer = lineage::heuristics::GreedyLineageAgglomeration<>;
+
+template <class HEURISTIC>
+lineage::Solution
+solve(Parameters const& parameters, lineage::Problem const& problem)
+{
+    if (parameters.numberOfBlocks != 1)
+        return lineage::heuristics::applyDecomposedHeuristic<HEURISTIC,
+                                                             Initializer>(
+            problem, parameters.terminationCost, parameters.birthCost,
+            parameters.bifurcationConstraint, parameters.solutionName,
+            parameters.maxDistance, parameters.logSettings,
+            parameters.decomposition, parameters.partitionSettings);
+    else
+        return lineage::heuristics::applyInitializedHeuristic<HEURISTIC,
+                                                              Initializer>(
+            problem, parameters.terminationCost, parameters.birthCost,
+            parameters.bifurcationConstraint, parameters.solutionName,
+            parameters.maxDistance, parameters.logSettings,
+            parameters.partitionSettings);
+}
+
 int
 main(int argc, char** argv) try {
     auto parameters = parseCommandLine(argc, argv);
 
+    if (parameters.numberOfThreads > 0)
+        lineage::ThreadPool::setSharedNumberOfThreads(
+            parameters.numberOfThreads);
+
     // load problem:
     auto problem = lineage::loadProblem(parameters.nodesFileName,
                                         parameters.edgesFileName);
@@ -111,9 +210,6 @@ main(int argc, char** argv) try {
         else
             e.weight = func(e.weight) + func(parameters.biasSpatial);
 
-    // heuristic for initial lineage.
-    using Initializer = lineage::heuristics::GreedyLineageAgglomeration<>;
-
     // global optimizer.
     using BranchingOpt = lineage::heuristics::branching::HungarianBranching<
         lineage::heuristics::PartitionGraph>;
@@ -124,18 +220,19 @@ main(int argc, char** argv) try {
     using HeuristicWithBifurcation =
         lineage::heuristics::LocalPartitionOptimizer<BranchingOpt,
                                                      LocalBranchingOpt>;
+    using IncrementalHeuristicWithBifurcation =
+        lineage::heuristics::IncrementalPartitionOptimizer<BranchingOpt>;
 
     // solve problem
     lineage::Solution solution;
-    if (parameters.bifurcationConstraint) {
-        solution = lineage::heuristics::applyInitializedHeuristic<
-            HeuristicWithBifurcation, Initializer>(
-            problem, parameters.terminationCost, parameters.birthCost,
-            parameters.bifurcationConstraint, parameters.solutionName,
-            parameters.maxDistance);
-    } else {
+    if (!parameters.bifurcationConstraint) {
         throw std::runtime_error(
             "Disabled bifurcation constraints are not supported.");
+    } else if (parameters.localBranching) {
+        solution = solve<HeuristicWithBifurcation>(parameters, problem);
+    } else {
+        solution =
+            solve<IncrementalHeuristicWithBifurcation>(parameters, problem);
     }
 
     // save solution:
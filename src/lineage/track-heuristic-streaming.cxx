@@ -0,0 +1,160 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <tclap/CmdLine.h>
+
+#include "lineage/heuristics/streaming-lineage.hxx"
+#include "lineage/problem.hxx"
+
+#include <levinkov/timer.hxx>
+
+struct Parameters
+{
+    std::string edgesFileName;
+    std::string nodesFileName;
+    std::string solutionName;
+    double biasSpatial{ .5 };
+    double biasTemporal{ .5 };
+    lineage::heuristics::StreamingLineage::Settings settings;
+};
+
+Parameters
+parseCommandLine(int argc, char** argv) try {
+    Parameters parameters;
+
+    TCLAP::CmdLine tclap("track", ' ', "1.0");
+    TCLAP::ValueArg<std::string> argNodesFileName(
+        "n", "nodes-file", "nodes information, sorted by frame", true,
+        parameters.nodesFileName, "nodes-file", tclap);
+    TCLAP::ValueArg<std::string> argEdgesFileName(
+        "e", "edges-file", "edges information, sorted by frame", true,
+        parameters.edgesFileName, "edges-file", tclap);
+    TCLAP::ValueArg<std::string> argSolutionName(
+        "s", "solution-name", "solution name", true, parameters.solutionName,
+        "solution-name", tclap);
+    TCLAP::ValueArg<double> argBiasSpatial(
+        "b", "cut-prior-spatial", "cut prior spatial", false,
+        parameters.biasSpatial, "cut prior spatial", tclap);
+    TCLAP::ValueArg<double> argBiasTemporal(
+        "t", "cut-prior-temporal", "cut prior temporal", false,
+        parameters.biasTemporal, "cut prior temporal", tclap);
+    TCLAP::ValueArg<double> argTerminationCost(
+        "T", "termination-cost", "early termination cost", false,
+        parameters.settings.costTermination, "early termination cost", tclap);
+    TCLAP::ValueArg<double> argBirthCost("B", "birth-cost", "birth cost", false,
+                                         parameters.settings.costBirth,
+                                         "birth cost", tclap);
+    TCLAP::ValueArg<size_t> argWindowSize(
+        "w", "window-size", "number of frames optimized jointly (at least 2)",
+        false, parameters.settings.windowSize, "frames", tclap);
+    TCLAP::SwitchArg argBifurcationConstraint(
+        "F", "bifurcation-constraint",
+        "Enforce bifurcation contraint. (Default: disabled).", tclap);
+
+    tclap.parse(argc, argv);
+
+    parameters.edgesFileName = argEdgesFileName.getValue();
+    parameters.nodesFileName = argNodesFileName.getValue();
+    parameters.solutionName = argSolutionName.getValue();
+    parameters.biasSpatial = argBiasSpatial.getValue();
+    parameters.biasTemporal = argBiasTemporal.getValue();
+    parameters.settings.costTermination = argTerminationCost.getValue();
+    parameters.settings.costBirth = argBirthCost.getValue();
+    parameters.settings.windowSize = argWindowSize.getValue();
+    parameters.settings.enforceBifurcationConstraint =
+        argBifurcationConstraint.getValue();
+
+    if (parameters.biasSpatial < std::numeric_limits<double>::epsilon() ||
+        parameters.biasSpatial > 1.0 - std::numeric_limits<double>::epsilon())
+        throw std::runtime_error("Spatial bias must be in the range (0, 1)");
+
+    if (parameters.biasTemporal < std::numeric_limits<double>::epsilon() ||
+        parameters.biasTemporal > 1.0 - std::numeric_limits<double>::epsilon())
+        throw std::runtime_error("Temporal bias must be in the range (0, 1)");
+
+    std::cout << "parameters:" << std::endl
+              << "- cut prior (spatial) : " << parameters.biasSpatial
+              << std::endl
+              << "- cut prior (temporal): " << parameters.biasTemporal
+              << std::endl
+              << "- cost of termination : "
+              << parameters.settings.costTermination << std::endl
+              << "- cost of birth: " << parameters.settings.costBirth
+              << std::endl
+              << "- bifurcation constraint: "
+              << (parameters.settings.enforceBifurcationConstraint ? "yes"
+                                                                    : "no")
+              << std::endl
+              << "- window size: " << parameters.settings.windowSize
+              << std::endl
+              << std::endl;
+
+    return parameters;
+} catch (TCLAP::ArgException& e) {
+    throw std::runtime_error(e.error());
+}
+
+int
+main(int argc, char** argv) try {
+    auto parameters = parseCommandLine(argc, argv);
+
+    // labels are written as soon as a frame is committed, in the format of
+    // SolutionGraph::save.
+    std::ofstream nodeLabelsFile(parameters.solutionName +
+                                 "-fragment-node-labels.txt");
+    std::ofstream cellEdgesFile(parameters.solutionName + "-cell-edges.txt");
+
+    if (!nodeLabelsFile || !cellEdgesFile)
+        throw std::runtime_error("could not open output files.");
+
+    size_t numberOfNodes = 0;
+    auto write = [&](
+        lineage::heuristics::StreamingLineage::CommittedFrame const& frame) {
+        for (size_t j = 0; j < frame.ids.size(); ++j)
+            nodeLabelsFile << frame.t << '\t' << frame.ids[j] << '\t'
+                           << frame.cells[j] << '\n';
+
+        for (auto const& e : frame.cellEdges)
+            cellEdgesFile << e.first << '\t' << e.second << '\n';
+
+        numberOfNodes += frame.ids.size();
+    };
+
+    levinkov::Timer timer;
+    timer.start();
+
+    lineage::heuristics::StreamingLineage lineage(parameters.settings, write);
+    lineage::FrameReader reader(parameters.nodesFileName,
+                                parameters.edgesFileName);
+
+    // map edge probabilities to edge cut costs:
+    lineage::NegativeLogProbabilityRatio<> func;
+
+    std::vector<lineage::Node> nodes;
+    std::vector<lineage::Edge> edges;
+    while (reader.read(nodes, edges)) {
+        for (auto& e : edges)
+            if (e.t0 != e.t1)
+                e.weight = func(e.weight) + func(parameters.biasTemporal);
+            else
+                e.weight = func(e.weight) + func(parameters.biasSpatial);
+
+        lineage.addFrame(std::move(nodes), std::move(edges));
+        nodes.clear();
+        edges.clear();
+    }
+    lineage.finish();
+
+    timer.stop();
+
+    std::cout << "Tracked " << numberOfNodes << " nodes in "
+              << reader.frame() + 1 << " frames as "
+              << lineage.numberOfCells() << " cells in "
+              << timer.get_elapsed_seconds() << " s." << std::endl;
+
+    return 0;
+} catch (const std::runtime_error& error) {
+    std::cerr << "error: " << error.what() << std::endl;
+    return 1;
+}
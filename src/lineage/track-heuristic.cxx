@@ -5,7 +5,11 @@
 #include "lineage/problem-graph.hxx"
 #include "lineage/solution-graph.hxx"
 
+#ifdef BGLA
+#include "lineage/heuristics/batch-greedy-lineage.hxx"
+#else
 #include "lineage/heuristics/greedy-lineage.hxx"
+#endif
 
 struct Parameters
 {
@@ -17,7 +21,10 @@ struct Parameters
     double terminationCost{ .0 };
     double birthCost{ .0 };
     bool bifurcationConstraint{ false };
+    lineage::OptimizationLog::Settings logSettings;
     size_t maxIter{ 500 };
+    lineage::heuristics::GreedySettings greedySettings;
+    size_t numberOfThreads{ 0 };
 };
 
 Parameters
@@ -52,6 +59,31 @@ parseCommandLine(int argc, char** argv) try {
     TCLAP::SwitchArg argBifurcationConstraint(
         "F", "bifurcation-constraint",
         "Enforce bifurcation contraint. (Default: disabled).", tclap);
+    TCLAP::SwitchArg argDisableLog(
+        "", "no-optimization-log",
+        "Do not write <solution-name>-optimization-log.txt.", tclap);
+    TCLAP::ValueArg<double> argLogFlushInterval(
+        "", "log-flush-interval",
+        "seconds between writes of the optimization log", false,
+        parameters.logSettings.flushInterval, "seconds", tclap);
+    TCLAP::ValueArg<size_t> argLogFlushSize(
+        "", "log-flush-size",
+        "bytes of the optimization log buffered before they are written",
+        false, parameters.logSettings.flushSize, "bytes", tclap);
+    TCLAP::SwitchArg argIncrementalReproposal(
+        "", "incremental-reproposal",
+        "After each move, re-propose only the moves whose cost change "
+        "depends on the changed clusters. (Default: all moves of all "
+        "neighbours).",
+        tclap);
+    TCLAP::ValueArg<size_t> argNumberOfThreads(
+        "", "threads", "size of the thread pool (0: all cores)", false,
+        parameters.numberOfThreads, "threads", tclap);
+#ifdef BGLA
+    TCLAP::ValueArg<size_t> argBatchSize(
+        "", "batch-size", "maximum number of moves applied per iteration",
+        false, parameters.greedySettings.maxBatchSize, "moves", tclap);
+#endif
 
     tclap.parse(argc, argv);
 
@@ -64,6 +96,18 @@ parseCommandLine(int argc, char** argv) try {
     parameters.birthCost = argBirthCost.getValue();
     parameters.maxIter = argMaxIter.getValue();
     parameters.bifurcationConstraint = argBifurcationConstraint.getValue();
+    parameters.logSettings.enabled = !argDisableLog.getValue();
+    parameters.logSettings.flushInterval = argLogFlushInterval.getValue();
+    parameters.logSettings.flushSize = argLogFlushSize.getValue();
+    parameters.greedySettings.incrementalReproposal =
+        argIncrementalReproposal.getValue();
+    parameters.numberOfThreads = argNumberOfThreads.getValue();
+#ifdef BGLA
+    parameters.greedySettings.maxBatchSize = argBatchSize.getValue();
+
+    if (parameters.greedySettings.maxBatchSize == 0)
+        throw std::runtime_error("Batch size must be at least 1");
+#endif
 
     if (parameters.biasSpatial < std::numeric_limits<double>::epsilon() ||
         parameters.biasSpatial > 1.0 - std::numeric_limits<double>::epsilon())
@@ -83,6 +127,10 @@ parseCommandLine(int argc, char** argv) try {
               << "- cost of birth: " << parameters.birthCost << std::endl
               << "- bifurcation constraint: "
               << (parameters.bifurcationConstraint ? "yes" : "no") << std::endl
+#ifdef BGLA
+              << "- batch size: " << parameters.greedySettings.maxBatchSize
+              << std::endl
+#endif
               << std::endl;
 
     return parameters;
@@ -94,6 +142,10 @@ int
 main(int argc, char** argv) try {
     auto parameters = parseCommandLine(argc, argv);
 
+    if (parameters.numberOfThreads > 0)
+        lineage::ThreadPool::setSharedNumberOfThreads(
+            parameters.numberOfThreads);
+
     // load problem:
     auto problem = lineage::loadProblem(parameters.nodesFileName,
                                         parameters.edgesFileName);
@@ -106,13 +158,18 @@ main(int argc, char** argv) try {
         else
             e.weight = func(e.weight) + func(parameters.biasSpatial);
 
+#ifdef BGLA
+    using Heuristic = lineage::heuristics::BatchGreedyLineageAgglomeration<>;
+#else
     using Heuristic = lineage::heuristics::GreedyLineageAgglomeration<>;
+#endif
 
     // solve problem:
     auto solution = lineage::heuristics::applyHeuristic<Heuristic>(
         problem, parameters.terminationCost, parameters.birthCost,
         parameters.bifurcationConstraint, parameters.solutionName,
-        parameters.maxIter);
+        parameters.maxIter, parameters.logSettings,
+        parameters.greedySettings);
 
     // save solution:
     lineage::ProblemGraph problemGraph(problem);
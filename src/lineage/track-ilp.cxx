@@ -18,6 +18,7 @@ struct Parameters {
     bool bifurcationConstraint { false };
     bool wheelConstraints { false };
     bool initialize { false };
+    lineage::OptimizationLog::Settings logSettings;
 };
 
 Parameters parseCommandLine(int argc, char** argv)
@@ -36,6 +37,9 @@ try
     TCLAP::SwitchArg argBifurcationConstraint("F", "bifurcation-constraint", "Enforce bifurcation contraint. (Default: disabled).", tclap);
     TCLAP::SwitchArg arg3WheelConstraints("W", "3-wheel-constraints", "Add optional 3-wheel inequalities. (Default: disabled).", tclap);
     TCLAP::SwitchArg argInitialize("I", "GLA-init", "Initialize with GLA. (Default: disabled).", tclap);
+    TCLAP::SwitchArg argDisableLog("", "no-optimization-log", "Do not write <solution-name>-optimization-log.txt.", tclap);
+    TCLAP::ValueArg<double> argLogFlushInterval("", "log-flush-interval", "seconds between writes of the optimization log", false, parameters.logSettings.flushInterval, "seconds", tclap);
+    TCLAP::ValueArg<size_t> argLogFlushSize("", "log-flush-size", "bytes of the optimization log buffered before they are written", false, parameters.logSettings.flushSize, "bytes", tclap);
     
     tclap.parse(argc, argv);
 
@@ -49,6 +53,9 @@ try
     parameters.bifurcationConstraint = argBifurcationConstraint.getValue();
     parameters.wheelConstraints = arg3WheelConstraints.getValue();
     parameters.initialize = argInitialize.getValue();
+    parameters.logSettings.enabled = !argDisableLog.getValue();
+    parameters.logSettings.flushInterval = argLogFlushInterval.getValue();
+    parameters.logSettings.flushSize = argLogFlushSize.getValue();
 
     if (parameters.biasSpatial < std::numeric_limits<double>::epsilon() || parameters.biasSpatial > 1.0 - std::numeric_limits<double>::epsilon())
         throw std::runtime_error("Spatial bias must be in the range (0, 1)");
@@ -97,7 +104,8 @@ try
         parameters.bifurcationConstraint,
         parameters.wheelConstraints,
         parameters.initialize,
-        parameters.solutionName
+        parameters.solutionName,
+        parameters.logSettings
     );
     
     // save solution: